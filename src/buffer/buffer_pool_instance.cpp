@@ -0,0 +1,828 @@
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "buffer/buffer_pool_instance.h"
+
+namespace cmudb {
+
+/*
+ * BufferPoolInstance Constructor
+ * When log_manager is nullptr, logging is disabled (for test purpose)
+ */
+BufferPoolInstance::BufferPoolInstance(size_t pool_size,
+                                       DiskManager *disk_manager,
+                                       LogManager *log_manager,
+                                       IOScheduler *io_scheduler,
+                                       ReplacerPolicy policy,
+                                       size_t compressed_cache_size)
+    : pool_size_(std::max<size_t>(pool_size, 1)), policy_(policy),
+      disk_manager_(disk_manager), log_manager_(log_manager),
+      io_scheduler_(io_scheduler), compressed_cache_(nullptr), use_count_(0),
+      prefetching_(0) {
+  if (compressed_cache_size > 0) {
+    compressed_cache_ = new CompressedCache(compressed_cache_size);
+  }
+  chunks_.push_back(AllocateChunk(pool_size_));
+  Page *pages = chunks_[0].pages;
+  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
+  if (policy == CLOCK_REPLACER) {
+    replacer_ = new ClockReplacer(pages, pool_size_);
+  } else if (policy == LRU_K_REPLACER) {
+    // as many evicted pages are remembered as there are pages in the pool
+    replacer_ = new LRUKReplacer<Page *>(LRU_K, LRU_K_CORRELATED_PERIOD,
+                                         pool_size_);
+  } else {
+    replacer_ = new LRUReplacer<Page *>;
+  }
+  free_list_ = new std::list<Page *>;
+
+  // put all the pages into free list
+  for (size_t i = 0; i < pool_size_; ++i) {
+    free_list_->push_back(&pages[i]);
+  }
+}
+
+/*
+ * BufferPoolInstance Deconstructor
+ */
+BufferPoolInstance::~BufferPoolInstance() {
+  {
+    // the I/O scheduler is still going to write into the frames
+    std::unique_lock<std::mutex> lock(latch_);
+    prefetch_done_.wait(lock, [this] { return prefetching_ == 0; });
+  }
+  for (auto &chunk : chunks_) {
+    FreeChunk(chunk);
+  }
+  for (auto &chunk : freed_chunks_) {
+    FreeChunk(chunk);
+  }
+  delete compressed_cache_;
+  delete page_table_;
+  delete replacer_;
+  delete free_list_;
+}
+
+/**
+ * 1. search hash table.
+ *  1.1 if exist, pin the page and return once it is loaded
+ *  1.2 if no exist, find a replacement entry from either free list or lru
+ *      replacer. (NOTE: always find from free list first)
+ * 2. If the entry chosen for replacement is dirty, write it back to disk.
+ * 3. Delete the entry for the old page from the hash table and insert an
+ * entry for the new page.
+ * 4. Update page metadata, read page content from disk file and return page
+ * pointer. The page of a read-only database is not copied, it points into the
+ * file mapping and must not be written
+ * The disk I/O is done without holding latch_, other threads that want the
+ * page meanwhile wait for the frame only
+ */
+Page *BufferPoolInstance::FetchPage(page_id_t page_id, bool *loaded,
+                                    PageHint hint) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  Page *page = nullptr;
+  if (page_id == INVALID_PAGE_ID) { return page; }
+
+  while (true) {
+    if (page_table_->Find(page_id, page)) {
+      replacer_erase(page);
+      pin_page(page);
+      page->referenced_ = false;
+      page->hint_ = std::max(page->hint_, hint);
+      WaitForIO(lock, page);
+      return page;
+    }
+    auto it = evicting_.find(page_id);
+    if (it == evicting_.end()) {
+      break;
+    }
+    // the page is being written back, read it once it is on disk
+    WaitForIO(lock, it->second);
+  }
+
+  page = GetFrame(lock, page_id, IO_PRIORITY_READ);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  page->hint_ = hint;
+  const char *mapped = disk_manager_->GetMappedPage(page_id);
+  if (mapped != nullptr) {
+    // zero copy, the page points right into the read-only file mapping
+    page->data_ = const_cast<char *>(mapped);
+  } else {
+    lock.unlock();
+    if (compressed_cache_ == nullptr ||
+        !compressed_cache_->Get(page_id, page->GetData())) {
+      ReadFrame(page_id, page->GetData());
+    }
+    lock.lock();
+  }
+  FinishIO(page);
+  page->resident_ = true;
+  if (loaded != nullptr) {
+    *loaded = true;
+  }
+  return page;
+}
+
+/*
+ * Implementation of unpin page
+ * if pin_count>0, decrement it and if it becomes zero, put it back to
+ * replacer if pin_count<=0 before this call, return false. is_dirty: set the
+ * dirty flag of this page
+ */
+bool BufferPoolInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Page *page = nullptr;
+  if (!page_table_->Find(page_id, page)) {
+    return false;
+  }
+  page->pin_count_--;
+  if (page->pin_count_ == 0) {
+    replacer_insert(page);
+  }
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  return true;
+}
+
+/*
+ * Pin the page in the frame a swizzled reference points to, without latch_
+ * and without looking it up in the page table. The page stays where it is in
+ * the replacer, see PickVictim(). Return nullptr if the frame holds another
+ * page by now, or is being loaded or evicted
+ */
+Page *BufferPoolInstance::FetchSwizzled(Page *page, page_id_t page_id) {
+  page->pin_count_++;
+  // checked after the pin, see Unswizzle()
+  if (page->resident_ && page->page_id_ == page_id) {
+    // the replacer hears of it when the page comes up as a victim
+    if (!page->referenced_.load(std::memory_order_relaxed)) {
+      page->referenced_.store(true, std::memory_order_relaxed);
+    }
+    return page;
+  }
+  UnpinFrame(page, false);
+  return nullptr;
+}
+
+/*
+ * Unpin by frame, for the pages fetched through swizzled references. latch_
+ * is only taken to set the dirty flag, or when the last pin is gone and the
+ * page is not in the replacer: it was pinned there through the latch, or a
+ * victim search dropped it because of the pin
+ */
+bool BufferPoolInstance::UnpinFrame(Page *page, bool is_dirty) {
+  if (is_dirty) {
+    std::lock_guard<std::mutex> guard(latch_);
+    page->is_dirty_ = true;
+    unpin_page(page);
+    return true;
+  }
+  if (--page->pin_count_ == 0 && !page->in_replacer_) {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (page->pin_count_ == 0 && !page->in_replacer_ && page->resident_) {
+      replacer_insert(page);
+    }
+  }
+  return true;
+}
+
+/*
+ * Used to flush a particular page of the buffer pool to disk. Should call the
+ * write_page method of the disk manager
+ * if page is not found in page table, return false
+ * NOTE: make sure page_id != INVALID_PAGE_ID
+ * The page is pinned while it is written, without holding latch_
+ */
+bool BufferPoolInstance::FlushPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  Page *page = nullptr;
+  if (!page_table_->Find(page_id, page)) {
+    return false;
+  }
+  replacer_erase(page);
+  pin_page(page);
+  WaitForIO(lock, page);
+  page->is_dirty_ = false;
+  lock.unlock();
+  WriteFrame(page_id, page->GetData());
+  lock.lock();
+  unpin_page(page);
+  return true;
+}
+
+/**
+ * If page is found within page table, remove this entry out of page table,
+ * reset page metadata and add it back to free list. If the page is found
+ * within page table, but pin_count != 0, return false. Deallocating the page
+ * is up to the caller
+ */
+bool BufferPoolInstance::DeletePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (compressed_cache_ != nullptr) {
+    compressed_cache_->Erase(page_id);
+  }
+  Page *page = nullptr;
+  if (page_table_->Find(page_id, page)) {
+    // also true while the page is being loaded
+    if (page->GetPinCount() != 0 || !Unswizzle(page)) { return false; }
+    replacer_remove(page);
+    free_list_->insert(free_list_->end(), page);
+    assert(page_table_->Remove(page_id));
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    page->data_ = FrameOf(page);
+    page->ResetMemory();
+  }
+  return true;
+}
+
+/**
+ * Choose a victim page either from free list or lru replacer (NOTE: always
+ * choose from free list first) for a page the caller has just allocated,
+ * update new page's metadata, zero out memory and add corresponding entry
+ * into page table. return nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolInstance::NewPage(page_id_t page_id, PageHint hint) {
+  std::unique_lock<std::mutex> lock(latch_);
+  Page *page = GetFrame(lock, page_id, IO_PRIORITY_READ);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  page->hint_ = hint;
+  page->ResetMemory();
+  page->is_dirty_ = true;
+  FinishIO(page);
+  page->resident_ = true;
+  return page;
+}
+
+/*
+ * Read the allocated pages within [page_id, page_id + count) that are not in
+ * the buffer pool yet, one vectored read per run of adjacent pages. The pages
+ * are left unpinned. At most half of the pool is used, so that a scan does not
+ * wipe out the rest of the working set
+ */
+void BufferPoolInstance::ReadAhead(page_id_t page_id, int count,
+                                   std::vector<page_id_t> *loaded_ids) {
+  LoadPages(page_id, count, loaded_ids, true);
+}
+
+/*
+ * Same as ReadAhead(), but return as soon as the reads are queued as
+ * prefetches. The frames stay pinned with their I/O in progress until their
+ * read is done, a FetchPage() meanwhile waits for it. Without an I/O scheduler
+ * the pages are read right away
+ */
+void BufferPoolInstance::Prefetch(page_id_t page_id, int count,
+                                  std::vector<page_id_t> *loaded_ids) {
+  LoadPages(page_id, count, loaded_ids, false);
+}
+
+/*
+ * Put the frame of a page that a scan is done with at the front of the free
+ * list. A dirty page is left to the replacer, so that it is written back with
+ * the others. The page is kept in the compressed cache, like in GetFrame()
+ */
+void BufferPoolInstance::ReleasePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  Page *page = nullptr;
+  if (!page_table_->Find(page_id, page) || page->GetPinCount() != 0 ||
+      page->is_dirty_ || !Unswizzle(page)) {
+    return;
+  }
+  replacer_remove(page);
+  page_table_->Remove(page_id);
+  if (compressed_cache_ != nullptr && page->data_ == FrameOf(page)) {
+    evicting_[page_id] = page;
+    page->io_in_progress_ = true;
+    lock.unlock();
+    compressed_cache_->Put(page_id, page->GetData());
+    lock.lock();
+    evicting_.erase(page_id);
+    FinishIO(page);
+  }
+  page->page_id_ = INVALID_PAGE_ID;
+  page->data_ = FrameOf(page);
+  free_list_->push_front(page);
+}
+
+/*
+ * Called by the background writer, so that misses find a free frame instead
+ * of writing back a dirty victim themselves. A page whose log records are
+ * not persistent yet is skipped rather than flushing the log, and goes back
+ * into the replacer. Writes and putting the pages into the compressed cache
+ * are done with latch_ released, like in GetFrame()
+ */
+size_t BufferPoolInstance::CleanFrames(size_t free_frames) {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<Page *> skipped;
+  size_t written = 0;
+  Page *page = nullptr;
+  while (free_list_->size() < free_frames && PickVictim(page)) {
+    bool cached = compressed_cache_ != nullptr;
+    if (page->data_ != FrameOf(page)) {
+      // a page of a read-only mapping, nothing to write back
+      page->data_ = FrameOf(page);
+      page->is_dirty_ = false;
+      cached = false;
+    }
+    if (page->is_dirty_ && ENABLE_LOGGING && log_manager_ != nullptr &&
+        page->GetLSN() > log_manager_->GetPersistentLSN()) {
+      skipped.push_back(page);
+      continue;
+    }
+    page_id_t page_id = page->GetPageId();
+    page_table_->Remove(page_id);
+    bool dirty = page->is_dirty_;
+    if (dirty || cached) {
+      evicting_[page_id] = page;
+      page->io_in_progress_ = true;
+      lock.unlock();
+      if (dirty) {
+        WriteFrame(page_id, page->GetData());
+      }
+      if (cached) {
+        compressed_cache_->Put(page_id, page->GetData());
+      }
+      lock.lock();
+      evicting_.erase(page_id);
+      page->is_dirty_ = false;
+      FinishIO(page);
+      if (dirty) {
+        written++;
+      }
+    }
+    page->page_id_ = INVALID_PAGE_ID;
+    free_list_->push_back(page);
+  }
+  for (auto skipped_page : skipped) {
+    skipped_page->resident_ = true;
+    replacer_insert(skipped_page);
+  }
+  return written;
+}
+
+/*
+ * Pages still being loaded are left out. Pages used through swizzled
+ * references since they were last considered for eviction count as the most
+ * recent ones
+ */
+void BufferPoolInstance::GetHotPages(std::vector<page_id_t> *page_ids) {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<Page *> pages;
+  for (auto &chunk : chunks_) {
+    for (size_t i = 0; i < chunk.size; ++i) {
+      Page *page = &chunk.pages[i];
+      if (page->page_id_ != INVALID_PAGE_ID && !page->io_in_progress_ &&
+          retired_.count(page) == 0) {
+        pages.push_back(page);
+      }
+    }
+  }
+  std::sort(pages.begin(), pages.end(), [](Page *a, Page *b) {
+    bool a_referenced = a->referenced_;
+    bool b_referenced = b->referenced_;
+    if (a_referenced != b_referenced) {
+      return a_referenced;
+    }
+    return a->last_used_ > b->last_used_;
+  });
+  for (auto page : pages) {
+    page_ids->push_back(page->page_id_);
+  }
+}
+
+/*
+ * Grow by taking back the frames retired by an earlier shrink first, then by
+ * adding a chunk. Shrink evicts the pages of the newest chunks, so that whole
+ * chunks can be freed. Done under latch_, which is only released to write
+ * dirty pages back
+ */
+size_t BufferPoolInstance::Resize(size_t pool_size) {
+  std::lock_guard<std::mutex> resize_guard(resize_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  pool_size = std::max<size_t>(pool_size, 1);
+  if (pool_size > pool_size_) {
+    Grow(pool_size - pool_size_);
+  } else if (pool_size < pool_size_) {
+    Shrink(lock, pool_size_ - pool_size);
+  }
+  return pool_size_;
+}
+
+/*
+ * Private helper to find a frame for page_id, from the free list first, then
+ * from the replacer. The frame is returned pinned, in the page table, and with
+ * its I/O in progress: whoever asks for the page meanwhile waits until the
+ * caller is done loading it and calls FinishIO(). A dirty victim is written
+ * back (after the log records up to its LSN are persistent) with latch_
+ * released, its page id is kept in evicting_ until it is on disk. The same
+ * goes for putting the victim into the compressed cache. The write back is
+ * scheduled with the given priority: a foreground miss waits for it, so it
+ * must not queue behind the background writes. A victim that pointed into the
+ * read-only file mapping gets its own frame back.
+ * Return nullptr if all the pages in pool are pinned. Caller must hold latch_
+ */
+Page *BufferPoolInstance::GetFrame(std::unique_lock<std::mutex> &lock,
+                                   page_id_t page_id, IOPriority priority) {
+  Page *page = nullptr;
+  bool victim_mapped = false;
+  if (!free_list_->empty()) {
+    page = *free_list_->begin();
+    free_list_->pop_front();
+  } else {
+    if (!PickVictim(page)) {
+      return nullptr;
+    }
+    if (page->data_ != FrameOf(page)) {
+      // a page of a read-only mapping, nothing to write back
+      page->data_ = FrameOf(page);
+      page->is_dirty_ = false;
+      victim_mapped = true;
+    }
+    page_table_->Remove(page->GetPageId());
+  }
+  page_id_t victim_id = page->GetPageId();
+  bool victim_dirty = page->is_dirty_;
+  bool victim_cached = compressed_cache_ != nullptr &&
+                       victim_id != INVALID_PAGE_ID && !victim_mapped;
+  page_table_->Insert(page_id, page);
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  page->io_in_progress_ = true;
+  page->hint_ = PAGE_HINT_NORMAL;
+  page->referenced_ = false;
+  pin_page(page);
+
+  if (victim_dirty || victim_cached) {
+    evicting_[victim_id] = page;
+    lock.unlock();
+    if (victim_dirty) {
+      // no steal
+      if(ENABLE_LOGGING && page->GetLSN() > log_manager_->GetPersistentLSN()){
+        log_manager_->Flush();
+        assert(page->GetLSN() <= log_manager_->GetPersistentLSN());
+      }
+      WriteFrame(victim_id, page->GetData(), priority);
+    }
+    if (victim_cached) {
+      compressed_cache_->Put(victim_id, page->GetData());
+    }
+    lock.lock();
+    evicting_.erase(victim_id);
+  }
+  return page;
+}
+
+/*
+ * Private helpers to allocate and free the frames of a chunk. The metadata of
+ * every page is on cache lines of its own, the page data is page aligned so
+ * that it can be handed to O_DIRECT as it is
+ */
+BufferPoolInstance::FrameChunk BufferPoolInstance::AllocateChunk(size_t size) {
+  void *pages = nullptr;
+  if (posix_memalign(&pages, CACHE_LINE_SIZE, size * sizeof(Page)) != 0) {
+    throw std::bad_alloc();
+  }
+  FrameChunk chunk = {static_cast<Page *>(pages),
+                      new FrameArena(size, PAGE_SIZE), size};
+  for (size_t i = 0; i < size; ++i) {
+    new (&chunk.pages[i]) Page();
+    chunk.pages[i].frame_ = chunk.frames->GetFrame(i);
+    chunk.pages[i].data_ = chunk.pages[i].frame_;
+  }
+  return chunk;
+}
+
+void BufferPoolInstance::FreeChunk(const FrameChunk &chunk) {
+  for (size_t i = 0; i < chunk.size; ++i) {
+    chunk.pages[i].~Page();
+  }
+  free(chunk.pages);
+  delete chunk.frames;
+}
+
+/*
+ * Private helper for Resize(), the new frames go to the free list. Caller must
+ * hold latch_
+ */
+void BufferPoolInstance::Grow(size_t count) {
+  for (auto &chunk : chunks_) {
+    for (size_t i = 0; i < chunk.size && count > 0; ++i) {
+      if (retired_.erase(&chunk.pages[i]) != 0) {
+        free_list_->push_back(&chunk.pages[i]);
+        pool_size_++;
+        count--;
+      }
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+  FrameChunk chunk = AllocateChunk(count);
+  chunks_.push_back(chunk);
+  if (policy_ == CLOCK_REPLACER) {
+    static_cast<ClockReplacer *>(replacer_)->AddFrames(chunk.pages, count);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    free_list_->push_back(&chunk.pages[i]);
+  }
+  pool_size_ += count;
+}
+
+/*
+ * Private helper for Resize(), retire up to count frames starting from the
+ * newest chunk, then free the chunks that are retired as a whole. The first
+ * chunk is never freed. Caller must hold latch_
+ */
+void BufferPoolInstance::Shrink(std::unique_lock<std::mutex> &lock,
+                                size_t count) {
+  for (size_t c = chunks_.size(); c-- > 0 && count > 0;) {
+    for (size_t i = 0; i < chunks_[c].size && count > 0; ++i) {
+      Page *page = &chunks_[c].pages[i];
+      if (retired_.count(page) == 0 && RetireFrame(lock, page)) {
+        pool_size_--;
+        count--;
+      }
+    }
+  }
+  while (chunks_.size() > 1) {
+    FrameChunk chunk = chunks_.back();
+    for (size_t i = 0; i < chunk.size; ++i) {
+      if (retired_.count(&chunk.pages[i]) == 0) {
+        return;
+      }
+    }
+    for (size_t i = 0; i < chunk.size; ++i) {
+      retired_.erase(&chunk.pages[i]);
+    }
+    if (policy_ == CLOCK_REPLACER) {
+      static_cast<ClockReplacer *>(replacer_)->RemoveFrames(chunk.pages);
+    }
+    // only the page data goes, see buffer_pool_instance.h
+    delete chunk.frames;
+    chunk.frames = nullptr;
+    freed_chunks_.push_back(chunk);
+    chunks_.pop_back();
+  }
+}
+
+/*
+ * Private helper for Shrink(), take the frame out of the free list or evict
+ * its page. A dirty page is written back pinned, like in FlushPage(), and the
+ * frame is left alone if the page was used meanwhile. Return false if the
+ * frame is in use. Caller must hold latch_
+ */
+bool BufferPoolInstance::RetireFrame(std::unique_lock<std::mutex> &lock,
+                                     Page *page) {
+  if (page->GetPinCount() != 0 || page->io_in_progress_ ||
+      page->io_waiters_ != 0) {
+    return false;
+  }
+  if (page->page_id_ == INVALID_PAGE_ID) {
+    free_list_->remove(page);
+    retired_.insert(page);
+    return true;
+  }
+  if (page->data_ != FrameOf(page)) {
+    // a page of a read-only mapping, nothing to write back
+    page->data_ = FrameOf(page);
+    page->is_dirty_ = false;
+  }
+  if (page->is_dirty_) {
+    replacer_erase(page);
+    pin_page(page);
+    page->is_dirty_ = false;
+    lock.unlock();
+    // no steal
+    if (ENABLE_LOGGING && log_manager_ != nullptr &&
+        page->GetLSN() > log_manager_->GetPersistentLSN()) {
+      log_manager_->Flush();
+    }
+    WriteFrame(page->GetPageId(), page->GetData());
+    lock.lock();
+    unpin_page(page);
+    if (page->GetPinCount() != 0 || page->is_dirty_) {
+      return false;
+    }
+  }
+  if (!Unswizzle(page)) {
+    return false;
+  }
+  replacer_remove(page);
+  page_table_->Remove(page->GetPageId());
+  page->page_id_ = INVALID_PAGE_ID;
+  retired_.insert(page);
+  return true;
+}
+
+/*
+ * Private helper to take a victim out of the replacer. Pages with a hint are
+ * passed over and put back, unless there are only such pages: then the least
+ * recently used one with the lowest hint goes. At most half of the pool is
+ * passed over, so that hinted pages can't take up all of it. Pages pinned
+ * through swizzled references are dropped, their last unpin puts them back.
+ * Pages used through swizzled references meanwhile get a second chance: they
+ * go back into the replacer as if they were just used, which is when it
+ * hears of these uses. The victim is unswizzled. Caller must hold latch_
+ */
+bool BufferPoolInstance::PickVictim(Page *&page) {
+  std::vector<Page *> passed;
+  Page *victim = nullptr;
+  size_t second_chances = 0;
+  while (victim == nullptr) {
+    while (passed.size() <= pool_size_ / 2 && replacer_->Victim(page)) {
+      page->in_replacer_ = false;
+      if (page->GetPinCount() != 0) {
+        continue;
+      }
+      if (page->referenced_ && second_chances++ < pool_size_) {
+        page->referenced_ = false;
+        page->last_used_ = ++use_count_;
+        replacer_insert(page);
+        continue;
+      }
+      if (page->hint_ == PAGE_HINT_NORMAL) {
+        victim = page;
+        break;
+      }
+      passed.push_back(page);
+    }
+    if (victim == nullptr && !passed.empty()) {
+      auto it = std::min_element(
+          passed.begin(), passed.end(),
+          [](Page *a, Page *b) { return a->hint_ < b->hint_; });
+      victim = *it;
+      passed.erase(it);
+    }
+    if (victim == nullptr) {
+      break;
+    }
+    if (!Unswizzle(victim)) {
+      // pinned since, dropped like the others
+      victim = nullptr;
+    }
+  }
+  for (auto passed_page : passed) {
+    replacer_insert(passed_page);
+  }
+  page = victim;
+  return victim != nullptr;
+}
+
+/*
+ * Private helper to take the page off limits for swizzled fetches before its
+ * frame is taken away. FetchSwizzled() pins before it checks resident_, and
+ * this clears resident_ before it checks the pin count, so either the fetch
+ * fails or the pin is seen here. Return false, leaving the page as it was, if
+ * the page is pinned. Caller must hold latch_
+ */
+bool BufferPoolInstance::Unswizzle(Page *page) {
+  bool resident = page->resident_.exchange(false);
+  if (page->GetPinCount() == 0) {
+    return true;
+  }
+  page->resident_ = resident;
+  return false;
+}
+
+/*
+ * Private helper for ReadAhead() and Prefetch()
+ */
+void BufferPoolInstance::LoadPages(page_id_t page_id, int count,
+                                   std::vector<page_id_t> *loaded_ids,
+                                   bool wait) {
+  if (disk_manager_->GetMappedPage(page_id) != nullptr) {
+    // pages are not copied into frames, just let the kernel read them ahead
+    disk_manager_->Advise(ACCESS_WILLNEED, page_id, count);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  count = std::min(count, static_cast<int>(pool_size_ / 2));
+  std::vector<Page *> loaded;
+  for (int i = 0; i < count; i++) {
+    Page *page = nullptr;
+    if (page_table_->Find(page_id + i, page) ||
+        evicting_.count(page_id + i) != 0 ||
+        !disk_manager_->IsAllocated(page_id + i)) {
+      continue;
+    }
+    page = GetFrame(lock, page_id + i, IO_PRIORITY_WRITE);
+    if (page == nullptr) {
+      // every frame is pinned
+      break;
+    }
+    loaded.push_back(page);
+    if (loaded_ids != nullptr) {
+      loaded_ids->push_back(page_id + i);
+    }
+  }
+  bool async = !wait && io_scheduler_ != nullptr;
+  if (async) {
+    prefetching_ += loaded.size();
+  }
+  lock.unlock();
+  if (compressed_cache_ != nullptr) {
+    // read from the disk, the image in the cache must not outlive it
+    for (auto page : loaded) {
+      compressed_cache_->Erase(page->GetPageId());
+    }
+  }
+
+  for (size_t i = 0; i < loaded.size();) {
+    size_t n = 1;
+    while (i + n < loaded.size() &&
+           loaded[i + n]->GetPageId() ==
+               loaded[i]->GetPageId() + static_cast<page_id_t>(n)) {
+      n++;
+    }
+    std::vector<Page *> run(loaded.begin() + i, loaded.begin() + i + n);
+    auto pages = std::make_shared<std::vector<char *>>();
+    for (auto page : run) {
+      pages->push_back(page->GetData());
+    }
+    page_id_t run_start = run[0]->GetPageId();
+    i += n;
+    if (async) {
+      io_scheduler_->ReadPages(run_start, n, pages->data(),
+                               IO_PRIORITY_PREFETCH,
+                               [this, run, pages] { FinishPrefetch(run); });
+    } else if (io_scheduler_ != nullptr) {
+      io_scheduler_->ReadPages(run_start, n, pages->data()).wait();
+    } else {
+      disk_manager_->ReadPages(run_start, n, pages->data());
+    }
+  }
+
+  if (!async) {
+    lock.lock();
+    for (auto page : loaded) {
+      FinishIO(page);
+      page->resident_ = true;
+      unpin_page(page);
+    }
+  }
+}
+
+/*
+ * Private helper called by the I/O scheduler once a prefetch is done
+ */
+void BufferPoolInstance::FinishPrefetch(const std::vector<Page *> &run) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (auto page : run) {
+    FinishIO(page);
+    page->resident_ = true;
+    unpin_page(page);
+  }
+  prefetching_ -= run.size();
+  if (prefetching_ == 0) {
+    prefetch_done_.notify_all();
+  }
+}
+
+/*
+ * Private helpers for the I/O in progress state of a frame. Caller must hold
+ * latch_, WaitForIO() releases it while waiting
+ */
+void BufferPoolInstance::WaitForIO(std::unique_lock<std::mutex> &lock,
+                                   Page *page) {
+  // a frame with waiters is not retired, see RetireFrame()
+  page->io_waiters_++;
+  page->io_done_.wait(lock, [page] { return !page->io_in_progress_; });
+  page->io_waiters_--;
+}
+
+void BufferPoolInstance::FinishIO(Page *page) {
+  page->io_in_progress_ = false;
+  page->io_done_.notify_all();
+}
+
+/*
+ * Private helpers for page I/O, a foreground read or a write of the given
+ * priority when there is an I/O scheduler
+ */
+void BufferPoolInstance::ReadFrame(page_id_t page_id, char *page_data) {
+  if (io_scheduler_ != nullptr) {
+    io_scheduler_->ReadPage(page_id, page_data, IO_PRIORITY_READ).wait();
+  } else {
+    disk_manager_->ReadPage(page_id, page_data);
+  }
+}
+
+void BufferPoolInstance::WriteFrame(page_id_t page_id, const char *page_data,
+                                    IOPriority priority) {
+  if (io_scheduler_ != nullptr) {
+    io_scheduler_->WritePage(page_id, page_data, priority).wait();
+  } else {
+    disk_manager_->WritePage(page_id, page_data);
+  }
+}
+
+} // namespace cmudb
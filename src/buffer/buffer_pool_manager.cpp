@@ -1,181 +1,355 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "buffer/buffer_pool_manager.h"
+#include "common/logger.h"
 
 namespace cmudb {
 
 /*
  * BufferPoolManager Constructor
  * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
                                      DiskManager *disk_manager,
-                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager),
-      log_manager_(log_manager) {
-  // a consecutive memory space for buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-  replacer_ = new LRUReplacer<Page *>;
-  free_list_ = new std::list<Page *>;
+                                     LogManager *log_manager,
+                                     IOScheduler *io_scheduler,
+                                     size_t num_instances,
+                                     ReplacerPolicy policy,
+                                     size_t compressed_cache_size)
+    : disk_manager_(disk_manager), writer_thread_(nullptr), writer_on_(false),
+      background_writes_(0), preload_thread_(nullptr), preload_stop_(false) {
+  num_instances = std::max<size_t>(std::min(num_instances, pool_size), 1);
+  for (size_t i = 0; i < num_instances; ++i) {
+    // the first instances take the remainder
+    size_t size = pool_size / num_instances + (i < pool_size % num_instances);
+    instances_.push_back(new BufferPoolInstance(
+        size, disk_manager, log_manager, io_scheduler, policy,
+        compressed_cache_size / num_instances));
+  }
+}
 
-  // put all the pages into free list
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_->push_back(&pages_[i]);
+BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundWriter();
+  if (preload_thread_ != nullptr) {
+    preload_stop_ = true;
+    preload_thread_->join();
+    delete preload_thread_;
   }
+  for (auto instance : instances_)
+    delete instance;
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id,
+                                   BufferAccessStrategy *strategy) {
+  if (strategy == nullptr)
+    return InstanceOf(page_id)->FetchPage(page_id);
+  bool loaded = false;
+  Page *page = InstanceOf(page_id)->FetchPage(page_id, &loaded);
+  if (loaded)
+    AddToRing(strategy, page_id);
+  return page;
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, PageHint hint) {
+  return InstanceOf(page_id)->FetchPage(page_id, nullptr, hint);
+}
+
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return InstanceOf(page_id)->UnpinPage(page_id, is_dirty);
 }
 
 /*
- * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
+ * Try the frame of the reference first, see BufferPoolInstance::FetchSwizzled()
  */
-BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
-  delete page_table_;
-  delete replacer_;
-  delete free_list_;
+Page *BufferPoolManager::FetchPage(page_id_t page_id, std::atomic<Page *> &ref,
+                                   PageHint hint) {
+  BufferPoolInstance *instance = InstanceOf(page_id);
+  Page *page = ref;
+  if (page != nullptr &&
+      (page = instance->FetchSwizzled(page, page_id)) != nullptr) {
+    return page;
+  }
+  page = instance->FetchPage(page_id, nullptr, hint);
+  if (page != nullptr) {
+    ref = page;
+  }
+  return page;
+}
+
+bool BufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+  // can't change while the page is pinned
+  return InstanceOf(page->GetPageId())->UnpinFrame(page, is_dirty);
+}
+
+/*
+ * One reference per slot a page can have, every slot takes at least a page id.
+ * Threads that get there first at the same time race to install theirs
+ */
+std::atomic<Page *> *BufferPoolManager::GetChildRefs(Page *page) {
+  std::atomic<Page *> *refs = page->child_refs_;
+  if (refs != nullptr) {
+    return refs;
+  }
+  size_t count = PAGE_SIZE / sizeof(page_id_t);
+  refs = new std::atomic<Page *>[count];
+  for (size_t i = 0; i < count; i++) {
+    refs[i] = nullptr;
+  }
+  std::atomic<Page *> *expected = nullptr;
+  if (!page->child_refs_.compare_exchange_strong(expected, refs)) {
+    delete[] refs;
+    return expected;
+  }
+  return refs;
+}
+
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  return InstanceOf(page_id)->FlushPage(page_id);
+}
+
+/**
+ * Allocate a page on disk, then get a frame for it from its instance. The page
+ * is deallocated again if all the pages of that instance are pinned
+ */
+Page *BufferPoolManager::NewPage(page_id_t &page_id, page_id_t near_page_id,
+                                 PageHint hint) {
+  page_id = disk_manager_->AllocatePage(near_page_id);
+  if (page_id == INVALID_PAGE_ID) {
+    // read-only database
+    return nullptr;
+  }
+  Page *page = InstanceOf(page_id)->NewPage(page_id, hint);
+  if (page == nullptr) {
+    disk_manager_->DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  return page;
 }
 
 /**
- * 1. search hash table.
- *  1.1 if exist, pin the page and return immediately
- *  1.2 if no exist, find a replacement entry from either free list or lru
- *      replacer. (NOTE: always find from free list first)
- * 2. If the entry chosen for replacement is dirty, write it back to disk.
- * 3. Delete the entry for the old page from the hash table and insert an
- * entry for the new page.
- * 4. Update page metadata, read page content from disk file and return page
- * pointer
+ * Remove the page from its instance, then deallocate it on disk. Return false
+ * if the page is pinned
  */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  std::lock_guard<std::mutex> guard(latch_);
+bool BufferPoolManager::DeletePage(page_id_t page_id) {
+  if (!InstanceOf(page_id)->DeletePage(page_id))
+    return false;
+  disk_manager_->DeallocatePage(page_id);
+  return true;
+}
 
-  Page *page = nullptr;
-  if (page_id == INVALID_PAGE_ID) { return page; }
+void BufferPoolManager::ReadAhead(page_id_t page_id, int count,
+                                  BufferAccessStrategy *strategy) {
+  LoadPages(page_id, count, strategy, true);
+}
 
-  if (page_table_->Find(page_id, page)) {
-    replacer_->Erase(page);
-    pin_page(page);
-    return page;
+void BufferPoolManager::PrefetchPages(page_id_t page_id, int count,
+                                      BufferAccessStrategy *strategy) {
+  LoadPages(page_id, count, strategy, false);
+}
+
+/*
+ * Called by a scan that is about to step onto next_page_id: keep the pages
+ * from there on within the extent, up to PREFETCH_WINDOW of them, in flight.
+ * window_end is the end of what the scan prefetched so far. A new batch is
+ * only started once half of the window is used up, so that the reads are
+ * large enough to be worth it
+ */
+void BufferPoolManager::PrefetchWindow(page_id_t next_page_id,
+                                       page_id_t &window_end,
+                                       BufferAccessStrategy *strategy) {
+  page_id_t extent_end = (next_page_id / EXTENT_SIZE + 1) * EXTENT_SIZE;
+  page_id_t start = next_page_id;
+  if (window_end > next_page_id && window_end <= extent_end) {
+    if (window_end - next_page_id > PREFETCH_WINDOW / 2)
+      return;
+    start = window_end;
   }
+  page_id_t end = std::min<page_id_t>(next_page_id + PREFETCH_WINDOW,
+                                      extent_end);
+  if (end <= start)
+    return;
+  PrefetchPages(start, end - start, strategy);
+  window_end = end;
+}
 
-  if (!free_list_->empty()) {
-    page = *free_list_->begin();
-    free_list_->pop_front();
-  } else {
-    if (!replacer_->Victim(page)) {
-      return nullptr;
-    }
-    if (page->is_dirty_) {
-      // no steal
-      if(ENABLE_LOGGING && page->GetLSN() > log_manager_->GetPersistentLSN()){
-        log_manager_->Flush();
-        assert(page->GetLSN() <= log_manager_->GetPersistentLSN());
-      }
-      disk_manager_->WritePage(page->GetPageId(), page->GetData());
-      page->is_dirty_ = false;
+/*
+ * Private helper for ReadAhead() and PrefetchPages(). Every stripe of the
+ * range is loaded by its own instance
+ */
+void BufferPoolManager::LoadPages(page_id_t page_id, int count,
+                                  BufferAccessStrategy *strategy, bool wait) {
+  std::vector<page_id_t> loaded;
+  if (strategy != nullptr) {
+    // the pages must still be there when the scan gets to them
+    strategy->Limit(GetPoolSize() / SCAN_RING_POOL_FRACTION);
+    count = std::min(count, static_cast<int>(strategy->GetRingSize() / 2));
+  }
+  while (count > 0) {
+    int run = std::min<page_id_t>(
+        count, BUFFER_POOL_STRIPE - page_id % BUFFER_POOL_STRIPE);
+    std::vector<page_id_t> *loaded_ids =
+        strategy != nullptr ? &loaded : nullptr;
+    if (wait) {
+      InstanceOf(page_id)->ReadAhead(page_id, run, loaded_ids);
+    } else {
+      InstanceOf(page_id)->Prefetch(page_id, run, loaded_ids);
     }
-    page_table_->Remove(page->GetPageId());
+    page_id += run;
+    count -= run;
   }
-  disk_manager_->ReadPage(page_id, page->GetData());
-  page_table_->Insert(page_id, page);
-  page->page_id_ = page_id;
-  pin_page(page);
-  return page;
+  for (auto id : loaded)
+    AddToRing(strategy, id);
+}
+
+void BufferPoolManager::StartBackgroundWriter(
+    size_t free_frames, std::chrono::milliseconds interval) {
+  std::lock_guard<std::mutex> guard(writer_latch_);
+  if (writer_on_)
+    return;
+  writer_on_ = true;
+  writer_thread_ = new std::thread(&BufferPoolManager::BackgroundWriterThread,
+                                   this, free_frames, interval);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::lock_guard<std::mutex> guard(writer_latch_);
+    if (!writer_on_)
+      return;
+    writer_on_ = false;
+  }
+  writer_cv_.notify_all();
+  writer_thread_->join();
+  delete writer_thread_;
+  writer_thread_ = nullptr;
 }
 
 /*
- * Implementation of unpin page
- * if pin_count>0, decrement it and if it becomes zero, put it back to
- * replacer if pin_count<=0 before this call, return false. is_dirty: set the
- * dirty flag of this page
+ * Split the pages between the instances like the constructor does
  */
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  std::lock_guard<std::mutex> guard(latch_);
-  Page *page = nullptr;
-  if (!page_table_->Find(page_id, page)) {
-    return false;
+size_t BufferPoolManager::Resize(size_t pool_size) {
+  size_t num_instances = instances_.size();
+  size_t total = 0;
+  for (size_t i = 0; i < num_instances; ++i) {
+    size_t size = pool_size / num_instances + (i < pool_size % num_instances);
+    total += instances_[i]->Resize(size);
+  }
+  return total;
+}
+
+size_t BufferPoolManager::GetNumCacheHits() {
+  size_t hits = 0;
+  for (auto instance : instances_)
+    hits += instance->GetNumCacheHits();
+  return hits;
+}
+
+size_t BufferPoolManager::GetPoolSize() {
+  size_t total = 0;
+  for (auto instance : instances_)
+    total += instance->GetPoolSize();
+  return total;
+}
+
+/*
+ * Instances keep their own recency order, their lists are interleaved. The
+ * file is a sequence of page ids, written next to it and then renamed so that
+ * a crash leaves the previous hot set
+ */
+bool BufferPoolManager::DumpHotSet(const std::string &file_name) {
+  std::vector<std::vector<page_id_t>> hot_pages(instances_.size());
+  size_t longest = 0;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    instances_[i]->GetHotPages(&hot_pages[i]);
+    longest = std::max(longest, hot_pages[i].size());
   }
-  page->pin_count_--;
-  if (page->pin_count_ == 0) {
-    replacer_->Insert(page);
+  std::vector<page_id_t> page_ids;
+  for (size_t rank = 0; rank < longest; ++rank) {
+    for (auto &pages : hot_pages) {
+      if (rank < pages.size())
+        page_ids.push_back(pages[rank]);
+    }
   }
-  if (is_dirty) {
-    page->is_dirty_ = true;
+
+  std::string tmp_name = file_name + ".tmp";
+  std::ofstream output(tmp_name, std::ios::binary | std::ios::trunc);
+  output.write(reinterpret_cast<const char *>(page_ids.data()),
+               page_ids.size() * sizeof(page_id_t));
+  output.close();
+  if (output.fail() || rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing hot set");
+    remove(tmp_name.c_str());
+    return false;
   }
   return true;
 }
 
+void BufferPoolManager::PreloadHotSet(const std::string &file_name,
+                                      bool wait) {
+  std::ifstream input(file_name, std::ios::binary);
+  if (!input)
+    return;
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  size_t pool_size = GetPoolSize();
+  while (page_ids.size() < pool_size &&
+         input.read(reinterpret_cast<char *>(&page_id), sizeof(page_id)))
+    page_ids.push_back(page_id);
+  if (wait) {
+    PreloadThread(std::move(page_ids));
+  } else if (preload_thread_ == nullptr) {
+    preload_thread_ = new std::thread(&BufferPoolManager::PreloadThread, this,
+                                      std::move(page_ids));
+  }
+}
+
 /*
- * Used to flush a particular page of the buffer pool to disk. Should call the
- * write_page method of the disk manager
- * if page is not found in page table, return false
- * NOTE: make sure page_id != INVALID_PAGE_ID
+ * Read the runs of adjacent pages of the hot set, at prefetch priority
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  std::lock_guard<std::mutex> guard(latch_);
-  Page *page = nullptr;
-  if (!page_table_->Find(page_id, page)) {
-    return false;
+void BufferPoolManager::PreloadThread(std::vector<page_id_t> page_ids) {
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()),
+                 page_ids.end());
+  for (size_t i = 0; i < page_ids.size() && !preload_stop_;) {
+    size_t n = 1;
+    while (i + n < page_ids.size() &&
+           page_ids[i + n] == page_ids[i] + static_cast<page_id_t>(n))
+      n++;
+    LoadPages(page_ids[i], n, nullptr, true);
+    i += n;
   }
-  disk_manager_->WritePage(page_id, page->GetData());
-  page->is_dirty_ = false;
-  return true;
 }
 
-/**
- * User should call this method for deleting a page. This routine will call
- * disk manager to deallocate the page. First, if page is found within page
- * table, buffer pool manager should be responsible for removing this entry out
- * of page table, resetting page metadata and adding back to free list. Second,
- * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+/*
+ * Every round, each instance frees its share of free_frames
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  std::lock_guard<std::mutex> guard(latch_);
-  Page *page = nullptr;
-  if (page_table_->Find(page_id, page)) {
-    if (page->GetPinCount() != 0) { return false; }
-    assert(replacer_->Erase(page));
-    free_list_->insert(free_list_->end(), page);
-    assert(page_table_->Remove(page_id));
-    page->page_id_ = INVALID_PAGE_ID;
-    page->is_dirty_ = false;
-    page->ResetMemory();
+void BufferPoolManager::BackgroundWriterThread(
+    size_t free_frames, std::chrono::milliseconds interval) {
+  size_t per_instance = (free_frames + instances_.size() - 1) /
+                        instances_.size();
+  std::unique_lock<std::mutex> lock(writer_latch_);
+  while (writer_on_) {
+    lock.unlock();
+    for (auto instance : instances_)
+      background_writes_ += instance->CleanFrames(per_instance);
+    lock.lock();
+    writer_cv_.wait_for(lock, interval, [this] { return !writer_on_; });
   }
-  disk_manager_->DeallocatePage(page_id);
-  return true;
 }
 
-/**
- * User should call this method if needs to create a new page. This routine
- * will call disk manager to allocate a page.
- * Buffer pool manager should be responsible to choose a victim page either
- * from free list or lru replacer(NOTE: always choose from free list first),
- * update new page's metadata, zero out memory and add corresponding entry
- * into page table. return nullptr if all the pages in pool are pinned
+/*
+ * Private helper to take a page that was just loaded for a scan into its
+ * ring, and recycle the frames of the pages that fall out of it. The ring is
+ * kept to a fraction of the pool, which may have been resized
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  std::lock_guard<std::mutex> guard(latch_);
-  Page *page = nullptr;
-  if (!free_list_->empty()) {
-    page = *free_list_->begin();
-    free_list_->pop_front();
-  } else {
-    if (!replacer_->Victim(page)) {
-      return nullptr;
-    }
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page->GetPageId(), page->GetData());
-      page->is_dirty_ = false;
-    }
-    page_table_->Remove(page->GetPageId());
-  }
-  page_id = disk_manager_->AllocatePage();
-  page_table_->Insert(page_id, page);
-  page->ResetMemory();
-  page->page_id_ = page_id;
-  page->is_dirty_ = true;
-  pin_page(page);
-  return page;
+void BufferPoolManager::AddToRing(BufferAccessStrategy *strategy,
+                                  page_id_t page_id) {
+  strategy->Limit(GetPoolSize() / SCAN_RING_POOL_FRACTION);
+  for (page_id_t oldest = strategy->Add(page_id); oldest != INVALID_PAGE_ID;
+       oldest = strategy->Pop())
+    InstanceOf(oldest)->ReleasePage(oldest);
 }
+
 } // namespace cmudb
@@ -0,0 +1,105 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+
+namespace cmudb {
+
+ClockReplacer::ClockReplacer(Page *pages, size_t num_pages)
+    : num_pages_(0), hand_(0), size_(0) {
+  AddFrames(pages, num_pages);
+}
+
+ClockReplacer::~ClockReplacer() {
+  for (auto &chunk : chunks_)
+    delete[] chunk.state;
+}
+
+/*
+ * The page is unpinned: it can be evicted, and it was just used
+ */
+void ClockReplacer::Insert(Page *const &value) {
+  uint8_t old = StateOf(value).exchange(EVICTABLE | REFERENCED);
+  if (!(old & EVICTABLE))
+    size_++;
+}
+
+/*
+ * Give the pages under the hand a second chance if they were used, until an
+ * evictable one that was not is found. Each frame is looked at most 3 times,
+ * which covers a full sweep to clear the reference bits even while other
+ * threads keep setting them. Return false if nothing was found
+ */
+bool ClockReplacer::Victim(Page *&value) {
+  for (size_t n = 0; n < 3 * num_pages_ && size_ > 0; n++) {
+    size_t i = hand_++ % num_pages_;
+    auto chunk = chunks_.begin();
+    while (i >= chunk->num_pages) {
+      i -= chunk->num_pages;
+      ++chunk;
+    }
+    std::atomic<uint8_t> &word = chunk->state[i];
+    uint8_t state = word;
+    if (!(state & EVICTABLE))
+      continue;
+    if (state & REFERENCED) {
+      // may fail if the page was just pinned, then it's not a candidate anyway
+      word.compare_exchange_strong(state, EVICTABLE);
+      continue;
+    }
+    if (word.compare_exchange_strong(state, 0)) {
+      size_--;
+      value = &chunk->pages[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * The page is pinned, return false if it was not evictable
+ */
+bool ClockReplacer::Erase(Page *const &value) {
+  uint8_t old = StateOf(value).exchange(0);
+  if (!(old & EVICTABLE))
+    return false;
+  size_--;
+  return true;
+}
+
+size_t ClockReplacer::Size() { return size_; }
+
+void ClockReplacer::AddFrames(Page *pages, size_t num_pages) {
+  Chunk chunk = {pages, num_pages, new std::atomic<uint8_t>[num_pages]};
+  for (size_t i = 0; i < num_pages; i++)
+    chunk.state[i] = 0;
+  chunks_.push_back(chunk);
+  num_pages_ += num_pages;
+}
+
+void ClockReplacer::RemoveFrames(Page *pages) {
+  for (auto it = chunks_.begin(); it != chunks_.end(); ++it) {
+    if (it->pages == pages) {
+      num_pages_ -= it->num_pages;
+      delete[] it->state;
+      chunks_.erase(it);
+      return;
+    }
+  }
+}
+
+/*
+ * Private helper, there are only a few chunks
+ */
+std::atomic<uint8_t> &ClockReplacer::StateOf(Page *page) {
+  for (auto &chunk : chunks_) {
+    if (page >= chunk.pages && page < chunk.pages + chunk.num_pages)
+      return chunk.state[page - chunk.pages];
+  }
+  assert(false);
+  return chunks_[0].state[0];
+}
+
+} // namespace cmudb
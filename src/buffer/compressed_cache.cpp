@@ -0,0 +1,77 @@
+/**
+ * compressed_cache.cpp
+ */
+#include "buffer/compressed_cache.h"
+#include "disk/lz_codec.h"
+
+namespace cmudb {
+
+CompressedCache::CompressedCache(size_t capacity)
+    : capacity_(capacity), size_(0), num_hits_(0) {}
+
+/*
+ * Compress without holding latch_, then drop the oldest images until the new
+ * one fits
+ */
+void CompressedCache::Put(page_id_t page_id, const char *page_data) {
+  char buf[MAX_PAGE_SIZE];
+  int size = LZCodec::Compress(page_data, PAGE_SIZE, buf, PAGE_SIZE / 2);
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end())
+    Remove(it);
+  if (size == 0 || static_cast<size_t>(size) > capacity_)
+    return;
+  while (size_ + size > capacity_)
+    Remove(entries_.find(lru_.front()));
+  Entry &entry = entries_[page_id];
+  entry.image.assign(buf, buf + size);
+  entry.lru = lru_.insert(lru_.end(), page_id);
+  size_ += size;
+}
+
+/*
+ * The image is taken out under latch_, and decompressed without it
+ */
+bool CompressedCache::Get(page_id_t page_id, char *page_data) {
+  std::vector<char> image;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = entries_.find(page_id);
+    if (it == entries_.end())
+      return false;
+    image.swap(it->second.image);
+    size_ -= image.size();
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+  if (LZCodec::Decompress(image.data(), image.size(), page_data, PAGE_SIZE) !=
+      PAGE_SIZE)
+    return false;
+  num_hits_++;
+  return true;
+}
+
+void CompressedCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end())
+    Remove(it);
+}
+
+size_t CompressedCache::GetSize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
+
+/*
+ * Private helper, caller must hold latch_
+ */
+void CompressedCache::Remove(
+    std::unordered_map<page_id_t, Entry>::iterator it) {
+  size_ -= it->second.image.size();
+  lru_.erase(it->second.lru);
+  entries_.erase(it);
+}
+
+} // namespace cmudb
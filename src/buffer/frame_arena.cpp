@@ -0,0 +1,46 @@
+/**
+ * frame_arena.cpp
+ */
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+
+#include "buffer/frame_arena.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+/**
+ * Map the frames, with explicit huge pages if possible. The size is rounded
+ * up to whole huge pages, the mapping is zeroed
+ */
+FrameArena::FrameArena(size_t num_frames, size_t frame_size)
+    : base_(nullptr), frame_size_(frame_size), huge_pages_(false) {
+  size_ = num_frames * frame_size;
+  if (size_ >= HUGE_PAGE_SIZE) {
+    size_ = (size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      base_ = static_cast<char *>(addr);
+      huge_pages_ = true;
+      return;
+    }
+  }
+  size_ = std::max<size_t>(size_, 1);
+  void *addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  base_ = static_cast<char *>(addr);
+#ifdef MADV_HUGEPAGE
+  if (size_ >= HUGE_PAGE_SIZE && madvise(base_, size_, MADV_HUGEPAGE) != 0) {
+    LOG_DEBUG("transparent huge pages not available");
+  }
+#endif
+}
+
+FrameArena::~FrameArena() { munmap(base_, size_); }
+
+} // namespace cmudb
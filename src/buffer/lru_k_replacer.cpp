@@ -0,0 +1,138 @@
+/**
+ * LRU-K implementation
+ */
+#include "buffer/lru_k_replacer.h"
+
+namespace cmudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k, size_t correlated_period,
+                              size_t history_size)
+    : k_(k), correlated_period_(correlated_period),
+      history_size_(history_size), now_(0) {}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record a reference to value, and make it evictable
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  now_++;
+  auto it = map_.find(value);
+  if (it != map_.end()) {
+    order_.erase(it->second);
+    map_.erase(it);
+  }
+  History &history = history_[HistoryKey(value)];
+  if (history.retained) {
+    retained_.erase(history.retained_pos);
+    history.retained = false;
+  }
+  if (!history.refs.empty() &&
+      now_ - history.refs.front() <= correlated_period_) {
+    // correlated, the same use of the page as the previous reference
+    history.refs.front() = now_;
+  } else {
+    history.refs.push_front(now_);
+    if (history.refs.size() > k_)
+      history.refs.pop_back();
+  }
+  bool full = history.refs.size() == k_;
+  Entry entry(full, full ? history.refs.back() : history.refs.front(), value);
+  map_[value] = order_.insert(entry).first;
+}
+
+/* Pop the value with the largest backward K-distance that was not referenced
+ * within the correlated reference period, or else the one with the largest
+ * distance, to argument "value", and return true. If there is nothing to
+ * evict, return false. The history of the value is retained
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (order_.empty()) {
+    return false;
+  }
+  auto victim = order_.begin();
+  for (auto it = order_.begin(); it != order_.end(); ++it) {
+    const History &history = history_[HistoryKey(std::get<2>(*it))];
+    if (now_ - history.refs.front() > correlated_period_) {
+      victim = it;
+      break;
+    }
+  }
+  value = std::get<2>(*victim);
+  order_.erase(victim);
+  map_.erase(value);
+
+  Retain(HistoryKey(value));
+  return true;
+}
+
+/*
+ * Remove value from the values that can be evicted. If removal is successful,
+ * return true, otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = map_.find(value);
+  if (it == map_.end()) {
+    return false;
+  }
+  order_.erase(it->second);
+  map_.erase(it);
+  return true;
+}
+
+/*
+ * For the values that leave the pool by other ways than Victim(), e.g. the
+ * pages of a scan given back to the free list, so that their history is
+ * bounded too
+ */
+template <typename T> bool LRUKReplacer<T>::Remove(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  bool found = false;
+  auto it = map_.find(value);
+  if (it != map_.end()) {
+    order_.erase(it->second);
+    map_.erase(it);
+    found = true;
+  }
+  int64_t key = HistoryKey(value);
+  auto history = history_.find(key);
+  if (history != history_.end() && !history->second.retained) {
+    Retain(key);
+  }
+  return found;
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return map_.size();
+}
+
+template <typename T> size_t LRUKReplacer<T>::GetHistorySize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return history_.size();
+}
+
+/*
+ * Private helper to put the history of an evicted value among the retained
+ * ones, the oldest retained history goes if there are too many. Caller must
+ * hold latch_
+ */
+template <typename T> void LRUKReplacer<T>::Retain(int64_t key) {
+  History &history = history_[key];
+  history.retained = true;
+  history.retained_pos = retained_.insert(retained_.end(), key);
+  if (retained_.size() > history_size_) {
+    history_.erase(retained_.front());
+    retained_.pop_front();
+  }
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace cmudb
@@ -0,0 +1,325 @@
+/**
+ * vm_cache.cpp
+ */
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+#include "buffer/vm_cache.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+/*
+ * Reserve the page memory and the state words without committing any memory,
+ * the kernel only backs what is touched
+ */
+VMCache::VMCache(size_t pool_size, DiskManager *disk_manager,
+                 LogManager *log_manager, size_t max_pages)
+    : pool_size_(std::max<size_t>(pool_size, 1)), max_pages_(max_pages),
+      disk_manager_(disk_manager), log_manager_(log_manager), hand_(0) {
+  // page sizes are powers of two, so are OS pages
+  stride_ = std::max<size_t>(PAGE_SIZE, sysconf(_SC_PAGESIZE));
+  void *frames = mmap(nullptr, max_pages_ * stride_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  void *states =
+      mmap(nullptr, max_pages_ * sizeof(std::atomic<uint64_t>),
+           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+           -1, 0);
+  if (frames == MAP_FAILED || states == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  frames_ = static_cast<char *>(frames);
+  // zeroed memory is a valid array of evicted state words
+  states_ = static_cast<std::atomic<uint64_t> *>(states);
+
+  // every page on cache lines of its own
+  void *slots = nullptr;
+  if (posix_memalign(&slots, CACHE_LINE_SIZE, pool_size_ * sizeof(Page)) != 0) {
+    throw std::bad_alloc();
+  }
+  slots_ = static_cast<Page *>(slots);
+  owners_ = new std::atomic<page_id_t>[pool_size_];
+  dirty_ = new std::atomic<bool>[pool_size_];
+  referenced_ = new std::atomic<bool>[pool_size_];
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (&slots_[i]) Page();
+    owners_[i] = INVALID_PAGE_ID;
+    dirty_[i] = false;
+    referenced_[i] = false;
+    free_slots_.push_back(pool_size_ - 1 - i);
+  }
+}
+
+VMCache::~VMCache() {
+  munmap(frames_, max_pages_ * stride_);
+  munmap(states_, max_pages_ * sizeof(std::atomic<uint64_t>));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    slots_[i].~Page();
+  }
+  free(slots_);
+  delete[] owners_;
+  delete[] dirty_;
+  delete[] referenced_;
+}
+
+/**
+ * A resident page is pinned, then the state word is read again: if an evictor
+ * locked it meanwhile, the pin is taken back and the lookup starts over. The
+ * evictor does the opposite (lock, then look at the pin count), so one of the
+ * two always sees the other. An evicted page is locked by whoever gets there
+ * first and loaded, the others wait for it
+ */
+Page *VMCache::FetchPage(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= max_pages_) {
+    LOG_DEBUG("page %" PRId64 " out of the reserved range", page_id);
+    return nullptr;
+  }
+  std::atomic<uint64_t> &state = states_[page_id];
+  while (true) {
+    uint64_t s = state;
+    if (s == 0) {
+      if (state.compare_exchange_strong(s, LOCKED)) {
+        return Load(page_id, true);
+      }
+      continue;
+    }
+    if (s & LOCKED) {
+      std::this_thread::yield();
+      continue;
+    }
+    Page *page = &slots_[s - 1];
+    page->pin_count_++;
+    if (state == s) {
+      referenced_[s - 1] = true;
+      return page;
+    }
+    page->pin_count_--;
+  }
+}
+
+/*
+ * The dirty flag is set before the pin is released, so that an evictor that
+ * sees the page unpinned also sees it dirty
+ */
+bool VMCache::UnpinPage(page_id_t page_id, bool is_dirty) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= max_pages_) {
+    return false;
+  }
+  uint64_t s;
+  // a page that is pinned is only locked for a moment, by a failed eviction
+  while ((s = states_[page_id]) & LOCKED) {
+    std::this_thread::yield();
+  }
+  if (s == 0) {
+    return false;
+  }
+  Page *page = &slots_[s - 1];
+  if (page->GetPinCount() <= 0) {
+    return false;
+  }
+  if (is_dirty) {
+    dirty_[s - 1] = true;
+  }
+  page->pin_count_--;
+  return true;
+}
+
+/*
+ * Write the page back if it is resident, pinned meanwhile
+ */
+bool VMCache::FlushPage(page_id_t page_id) {
+  Page *page = PinResident(page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  dirty_[page - slots_] = false;
+  disk_manager_->WritePage(page_id, page->GetData());
+  page->pin_count_--;
+  return true;
+}
+
+/**
+ * Allocate a page on disk and load it zeroed. The page is deallocated again
+ * if every resident page is pinned
+ */
+Page *VMCache::NewPage(page_id_t &page_id, page_id_t near_page_id) {
+  page_id = disk_manager_->AllocatePage(near_page_id);
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  uint64_t s = 0;
+  if (static_cast<size_t>(page_id) >= max_pages_ ||
+      !states_[page_id].compare_exchange_strong(s, LOCKED)) {
+    LOG_DEBUG("can't load new page %" PRId64, page_id);
+    disk_manager_->DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+    return nullptr;
+  }
+  Page *page = Load(page_id, false);
+  if (page == nullptr) {
+    disk_manager_->DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  return page;
+}
+
+/**
+ * Drop the page without writing it back, then deallocate it. Return false if
+ * it is pinned
+ */
+bool VMCache::DeletePage(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= max_pages_) {
+    return false;
+  }
+  while (true) {
+    uint64_t s = states_[page_id];
+    if (s & LOCKED) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (s != 0) {
+      if (slots_[s - 1].GetPinCount() != 0) {
+        return false;
+      }
+      if (!Evict(s - 1, false)) {
+        continue;
+      }
+      FreeSlot(s - 1);
+    }
+    break;
+  }
+  disk_manager_->DeallocatePage(page_id);
+  return true;
+}
+
+/*****************************************************************************
+ * HELPER METHODS
+ *****************************************************************************/
+/*
+ * Give a slot to the page, whose state word the caller has locked, read it
+ * or zero it, then publish it pinned. Return nullptr and unlock it if every
+ * resident page is pinned
+ */
+Page *VMCache::Load(page_id_t page_id, bool read) {
+  size_t slot = GetSlot();
+  if (slot == NO_SLOT) {
+    states_[page_id] = 0;
+    return nullptr;
+  }
+  Page *page = &slots_[slot];
+  page->page_id_ = page_id;
+  page->data_ = frames_ + page_id * stride_;
+  if (read) {
+    disk_manager_->ReadPage(page_id, page->data_);
+  } else {
+    page->ResetMemory();
+  }
+  dirty_[slot] = !read;
+  referenced_[slot] = true;
+  owners_[slot] = page_id;
+  page->pin_count_++;
+  states_[page_id] = slot + 1;
+  return page;
+}
+
+/*
+ * Pin the page if it is resident, without loading it
+ */
+Page *VMCache::PinResident(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= max_pages_) {
+    return nullptr;
+  }
+  while (true) {
+    uint64_t s = states_[page_id];
+    if (s == 0) {
+      return nullptr;
+    }
+    if (s & LOCKED) {
+      std::this_thread::yield();
+      continue;
+    }
+    Page *page = &slots_[s - 1];
+    page->pin_count_++;
+    if (states_[page_id] == s) {
+      return page;
+    }
+    page->pin_count_--;
+  }
+}
+
+/*
+ * A free slot, or else the slot of a victim: CLOCK gives every recently used
+ * page a second chance. Return NO_SLOT if all the pages are pinned
+ */
+size_t VMCache::GetSlot() {
+  {
+    std::lock_guard<std::mutex> guard(free_latch_);
+    if (!free_slots_.empty()) {
+      size_t slot = free_slots_.back();
+      free_slots_.pop_back();
+      return slot;
+    }
+  }
+  for (size_t n = 0; n < 3 * pool_size_; ++n) {
+    size_t slot = hand_++ % pool_size_;
+    if (referenced_[slot].exchange(false)) {
+      continue;
+    }
+    if (Evict(slot, true)) {
+      return slot;
+    }
+  }
+  return NO_SLOT;
+}
+
+/*
+ * Take the page out of the slot if it is unpinned, writing it back first if
+ * asked to and dirty (after the log records up to its LSN are persistent).
+ * The slot is then owned by the caller
+ */
+bool VMCache::Evict(size_t slot, bool write_back) {
+  page_id_t page_id = owners_[slot];
+  if (page_id == INVALID_PAGE_ID) {
+    // free, or being loaded
+    return false;
+  }
+  uint64_t s = slot + 1;
+  if (!states_[page_id].compare_exchange_strong(s, s | LOCKED)) {
+    return false;
+  }
+  Page *page = &slots_[slot];
+  if (page->GetPinCount() != 0) {
+    states_[page_id] = s;
+    return false;
+  }
+  owners_[slot] = INVALID_PAGE_ID;
+  if (write_back && dirty_[slot]) {
+    // no steal
+    if (ENABLE_LOGGING && log_manager_ != nullptr &&
+        page->GetLSN() > log_manager_->GetPersistentLSN()) {
+      log_manager_->Flush();
+    }
+    disk_manager_->WritePage(page_id, page->GetData());
+  }
+  dirty_[slot] = false;
+  if (madvise(page->data_, stride_, MADV_DONTNEED) != 0) {
+    LOG_DEBUG("can't release the memory of page %" PRId64, page_id);
+  }
+  page->page_id_ = INVALID_PAGE_ID;
+  page->data_ = nullptr;
+  states_[page_id] = 0;
+  return true;
+}
+
+void VMCache::FreeSlot(size_t slot) {
+  std::lock_guard<std::mutex> guard(free_latch_);
+  free_slots_.push_back(slot);
+}
+
+} // namespace cmudb
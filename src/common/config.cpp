@@ -2,6 +2,7 @@
 
 namespace cmudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
+  int PAGE_SIZE = DEFAULT_PAGE_SIZE;
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
   std::chrono::duration<long long int> WAIT_TIMEOUT =
@@ -0,0 +1,285 @@
+/**
+ * compressed_disk_manager.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/compressed_disk_manager.h"
+#include "disk/lz_codec.h"
+
+namespace cmudb {
+
+// sectors of the largest slot, the one of an uncompressed page
+#define MAX_SLOT_SECTORS                                                       \
+  ((PAGE_SIZE + COMPRESSION_SECTOR_SIZE - 1) / COMPRESSION_SECTOR_SIZE)
+// sectors reserved at a time when the data file grows, PREALLOCATE_PAGES
+// images of a quarter of a page
+#define PREALLOCATE_SECTORS (PREALLOCATE_PAGES * MAX_SLOT_SECTORS / 4)
+
+static inline uint16_t SectorsOf(int size) {
+  return (size + COMPRESSION_SECTOR_SIZE - 1) / COMPRESSION_SECTOR_SIZE;
+}
+
+static inline off_t SectorOffset(uint32_t sector) {
+  return static_cast<off_t>(sector) * COMPRESSION_SECTOR_SIZE;
+}
+
+/**
+ * Constructor: open/create the database file, its page mapping table and data
+ * file. The read-only mmap mode can't be used, the file has no page images
+ */
+CompressedDiskManager::CompressedDiskManager(const std::string &db_file,
+                                             int flags)
+    : DiskManager(db_file, flags & ~DISK_READ_ONLY), map_fd_(-1),
+      data_fd_(-1), end_sector_(0), reserved_sector_(0) {
+  std::string::size_type n = db_file.find(".");
+  if (n == std::string::npos) {
+    LOG_DEBUG("wrong file format");
+    return;
+  }
+  map_fd_ = open((db_file.substr(0, n) + ".map").c_str(), O_RDWR | O_CREAT,
+                 0644);
+  data_fd_ = open((db_file.substr(0, n) + ".zdb").c_str(), O_RDWR | O_CREAT,
+                  0644);
+  if (map_fd_ < 0 || data_fd_ < 0) {
+    LOG_DEBUG("can't open page mapping table or data file");
+    return;
+  }
+  LoadMapping();
+  reserved_sector_ = end_sector_;
+}
+
+CompressedDiskManager::~CompressedDiskManager() {
+  if (map_fd_ >= 0)
+    close(map_fd_);
+  if (data_fd_ >= 0)
+    close(data_fd_);
+}
+
+/**
+ * Compress the page and write it into a new slot, then switch its mapping
+ * entry over
+ */
+void CompressedDiskManager::WritePage(page_id_t page_id,
+                                      const char *page_data) {
+  char buf[MAX_PAGE_SIZE];
+  // only worth it if at least a sector is saved
+  int size = LZCodec::Compress(page_data, PAGE_SIZE, buf,
+                               PAGE_SIZE - COMPRESSION_SECTOR_SIZE);
+  const char *image = buf;
+  if (size == 0) {
+    image = page_data;
+    size = PAGE_SIZE;
+  }
+  uint16_t sectors = SectorsOf(size);
+
+  MapEntry entry;
+  {
+    std::lock_guard<std::mutex> guard(map_latch_);
+    entry.sector = TakeSlot(sectors);
+    entry.sectors = sectors;
+    entry.size = static_cast<uint16_t>(size);
+  }
+
+  off_t offset = SectorOffset(entry.sector);
+  if (pwrite(data_fd_, image, size, offset) != size) {
+    LOG_DEBUG("I/O error while writing");
+    std::lock_guard<std::mutex> guard(map_latch_);
+    ReleaseSlot(entry.sector, entry.sectors);
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(map_latch_);
+  // whatever image is current by now, a concurrent write may have replaced
+  // the one seen above
+  MapEntry old_entry = {0, 0, 0};
+  if (page_id < static_cast<page_id_t>(map_.size()))
+    old_entry = map_[page_id];
+  WriteEntry(page_id, entry);
+  // the old slot can be reused now that nothing on disk refers to it anymore
+  if (old_entry.sectors != 0)
+    ReleaseSlot(old_entry.sector, old_entry.sectors);
+}
+
+/**
+ * Read the image of the page and decompress it into the given memory area. A
+ * page that has never been written reads as zeros
+ */
+void CompressedDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  MapEntry entry = {0, 0, 0};
+  {
+    std::lock_guard<std::mutex> guard(map_latch_);
+    if (page_id >= 0 && page_id < static_cast<page_id_t>(map_.size()))
+      entry = map_[page_id];
+  }
+  if (entry.sectors == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+
+  off_t offset = SectorOffset(entry.sector);
+  if (entry.size == PAGE_SIZE) {
+    // stored uncompressed
+    if (pread(data_fd_, page_data, PAGE_SIZE, offset) != PAGE_SIZE) {
+      LOG_DEBUG("I/O error while reading");
+      memset(page_data, 0, PAGE_SIZE);
+    }
+    return;
+  }
+  char buf[MAX_PAGE_SIZE];
+  if (pread(data_fd_, buf, entry.size, offset) != entry.size ||
+      LZCodec::Decompress(buf, entry.size, page_data, PAGE_SIZE) !=
+          PAGE_SIZE) {
+    LOG_DEBUG("I/O error or corrupted image while reading page %" PRId64,
+              page_id);
+    memset(page_data, 0, PAGE_SIZE);
+  }
+}
+
+/**
+ * Slots of adjacent pages are not adjacent, so pages are written one by one
+ */
+void CompressedDiskManager::WritePages(page_id_t page_id, int count,
+                                       const char *const *pages) {
+  for (int i = 0; i < count; i++)
+    WritePage(page_id + i, pages[i]);
+}
+
+void CompressedDiskManager::ReadPages(page_id_t page_id, int count,
+                                      char **pages) {
+  for (int i = 0; i < count; i++)
+    ReadPage(page_id + i, pages[i]);
+}
+
+/**
+ * Page images of all the objects share the data file, tablespaces can't be
+ * added
+ */
+int CompressedDiskManager::AddTablespace(const std::string &) {
+  LOG_DEBUG("can't add a tablespace to a compressed database");
+  return -1;
+}
+
+/**
+ * Deallocate page, and free its slot
+ */
+void CompressedDiskManager::DeallocatePage(page_id_t page_id) {
+  DiskManager::DeallocatePage(page_id);
+  std::lock_guard<std::mutex> guard(map_latch_);
+  if (page_id < 0 || page_id >= static_cast<page_id_t>(map_.size()) ||
+      map_[page_id].sectors == 0)
+    return;
+  MapEntry entry = map_[page_id];
+  WriteEntry(page_id, {0, 0, 0});
+  ReleaseSlot(entry.sector, entry.sectors);
+}
+
+/**
+ * Returns the bytes taken by the page images currently stored
+ */
+size_t CompressedDiskManager::GetStoredBytes() {
+  std::lock_guard<std::mutex> guard(map_latch_);
+  size_t bytes = 0;
+  for (auto &entry : map_)
+    bytes += entry.size;
+  return bytes;
+}
+
+/*****************************************************************************
+ * HELPER METHODS
+ *****************************************************************************/
+/*
+ * Read the page mapping table, and rebuild the free slots out of the gaps
+ * between the slots in use
+ */
+void CompressedDiskManager::LoadMapping() {
+  struct stat stat_buf;
+  if (fstat(map_fd_, &stat_buf) != 0)
+    return;
+  map_.resize(stat_buf.st_size / sizeof(MapEntry));
+  ssize_t size = map_.size() * sizeof(MapEntry);
+  if (pread(map_fd_, map_.data(), size, 0) != size) {
+    LOG_DEBUG("I/O error while reading page mapping table");
+    map_.clear();
+    return;
+  }
+
+  std::vector<std::pair<uint32_t, uint16_t>> slots;
+  for (auto &entry : map_) {
+    if (entry.sectors != 0)
+      slots.emplace_back(entry.sector, entry.sectors);
+  }
+  std::sort(slots.begin(), slots.end());
+  for (auto &slot : slots) {
+    while (end_sector_ < slot.first) {
+      uint16_t gap = std::min<uint32_t>(slot.first - end_sector_,
+                                        MAX_SLOT_SECTORS);
+      free_slots_.emplace(gap, end_sector_);
+      end_sector_ += gap;
+    }
+    end_sector_ = std::max(end_sector_, slot.first + slot.second);
+  }
+}
+
+/*
+ * Update an entry of the page mapping table, in memory and on disk. Caller
+ * must hold map_latch_
+ */
+void CompressedDiskManager::WriteEntry(page_id_t page_id,
+                                       const MapEntry &entry) {
+  if (page_id >= static_cast<page_id_t>(map_.size()))
+    map_.resize(page_id + 1, {0, 0, 0});
+  map_[page_id] = entry;
+  off_t offset = static_cast<off_t>(page_id) * sizeof(MapEntry);
+  if (pwrite(map_fd_, &entry, sizeof(MapEntry), offset) != sizeof(MapEntry)) {
+    LOG_DEBUG("I/O error while writing page mapping table");
+  }
+}
+
+/*
+ * Return the first sector of a slot of the given size, the smallest free slot
+ * that is large enough or else a new one at the end of the data file, which
+ * has space reserved PREALLOCATE_SECTORS at a time. Caller must hold
+ * map_latch_
+ */
+uint32_t CompressedDiskManager::TakeSlot(uint16_t sectors) {
+  auto it = free_slots_.lower_bound(sectors);
+  if (it == free_slots_.end()) {
+    uint32_t sector = end_sector_;
+    end_sector_ += sectors;
+    if (end_sector_ > reserved_sector_) {
+      uint32_t new_end =
+          std::max<uint32_t>(end_sector_,
+                             reserved_sector_ + PREALLOCATE_SECTORS);
+      // keep the file size, reads past it are zeros
+      if (fallocate(data_fd_, FALLOC_FL_KEEP_SIZE,
+                    SectorOffset(reserved_sector_),
+                    SectorOffset(new_end - reserved_sector_)) != 0) {
+        LOG_DEBUG("fallocate failed: %s", strerror(errno));
+      }
+      reserved_sector_ = new_end;
+    }
+    return sector;
+  }
+  uint16_t size = it->first;
+  uint32_t sector = it->second;
+  free_slots_.erase(it);
+  if (size > sectors)
+    free_slots_.emplace(size - sectors, sector + sectors);
+  return sector;
+}
+
+/*
+ * Caller must hold map_latch_
+ */
+void CompressedDiskManager::ReleaseSlot(uint32_t sector, uint16_t sectors) {
+  free_slots_.emplace(sectors, sector);
+}
+
+} // namespace cmudb
@@ -1,11 +1,20 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <new>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 
 #include "common/logger.h"
 #include "disk/disk_manager.h"
@@ -14,19 +23,68 @@ namespace cmudb {
 
 static char *buffer_used = nullptr;
 
+// PAGE_SIZE is shared by all databases of the process, it can only change
+// while no database is open
+static std::mutex page_size_latch;
+static int page_size_users = 0;
+
+
+static inline bool TestBit(const char *bitmap, int bit) {
+  return bitmap[bit / 8] & (1 << (bit % 8));
+}
+
+static inline void SetBit(char *bitmap, int bit) {
+  bitmap[bit / 8] |= (1 << (bit % 8));
+}
+
+static inline void ClearBit(char *bitmap, int bit) {
+  bitmap[bit / 8] &= ~(1 << (bit % 8));
+}
+
+// zeroed buffer, aligned so that it can be used with O_DIRECT
+static char *AllocateAligned(size_t size) {
+  char *buf = nullptr;
+  if (posix_memalign(reinterpret_cast<void **>(&buf), DIRECT_IO_ALIGNMENT,
+                     size) != 0)
+    throw std::bad_alloc();
+  memset(buf, 0, size);
+  return buf;
+}
+
+static char *AllocateBitmap() { return AllocateAligned(PAGE_SIZE); }
+
+// number of bitmap pages that cover the pages of a tablespace
+#define MAX_GROUPS (static_cast<size_t>(LOCAL_PAGE_MASK + 1) / BITMAP_PAGE_BITS)
+
+// a power of two within [MIN_PAGE_SIZE, MAX_PAGE_SIZE], so that a bitmap page
+// covers whole extents
+static bool IsValidPageSize(int page_size) {
+  return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
 /**
- * Constructor: open/create a single database file & log file
+ * Constructor: open/create the database file, its tablespaces & log file
  * @input db_file: database file name
+ * @input flags: DiskManagerFlags to open the database file with
+ * @input page_size: page size of a newly created database file
+ * The global PAGE_SIZE is set to the page size of the database. A database
+ * whose page size differs from the one of the databases that are already open
+ * is refused
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
-  std::string::size_type n = file_name_.find(".");
+DiskManager::DiskManager(const std::string &db_file, int flags, int page_size)
+    : flags_(flags), format_version_(DB_FORMAT_VERSION), files_(),
+      num_tablespaces_(0), owns_page_size_(false), num_flushes_(0),
+      flush_log_(false), flush_log_f_(nullptr) {
+  files_[0] = new DataFile;
+  files_[0]->name = db_file;
+  num_tablespaces_ = 1;
+  std::string::size_type n = db_file.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  log_name_ = db_file.substr(0, n) + ".log";
 
   log_io_.open(log_name_,
                std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
@@ -42,61 +100,232 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  if (page_size == 0)
+    page_size = DEFAULT_PAGE_SIZE;
+  if (!IsValidPageSize(page_size)) {
+    LOG_DEBUG("invalid page size %d", page_size);
+    page_size = DEFAULT_PAGE_SIZE;
+  }
+  // pages of a read-only database are served from the page cache through the
+  // mapping
+  if (IsReadOnly())
+    flags_ &= ~DISK_DIRECT_IO;
+
+  std::vector<std::string> tablespaces;
+  if (!OpenDataFile(files_[0], page_size, &tablespaces))
+    return;
+  for (auto &name : tablespaces) {
+    // keep the ids of the following tablespaces even if this one is missing
+    DataFile *file = new DataFile;
+    file->name = name;
+    OpenDataFile(file, PAGE_SIZE, nullptr);
+    files_[num_tablespaces_] = file;
+    num_tablespaces_++;
   }
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  for (int i = 0; i < num_tablespaces_; i++) {
+    DataFile *file = files_[i];
+    if (file->map != nullptr)
+      munmap(file->map, file->map_size);
+    if (file->fd >= 0)
+      close(file->fd);
+    for (auto bitmap : file->bitmaps)
+      free(bitmap);
+    delete file;
+  }
   log_io_.close();
+  if (owns_page_size_) {
+    std::lock_guard<std::mutex> lock(page_size_latch);
+    page_size_users--;
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  if (IsReadOnly()) {
+    LOG_DEBUG("write to a read-only database");
+    return;
+  }
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr) {
+    LOG_DEBUG("page %" PRId64 " is in no tablespace", page_id);
+    return;
+  }
+  off_t offset = PageOffset(page_id);
+  char *bounce = nullptr;
+  if (NeedsBounceBuffer(page_data)) {
+    // O_DIRECT needs an aligned buffer
+    if (posix_memalign(reinterpret_cast<void **>(&bounce),
+                       DIRECT_IO_ALIGNMENT, PAGE_SIZE) != 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    memcpy(bounce, page_data, PAGE_SIZE);
+    page_data = bounce;
+  }
+  ssize_t write_count = pwrite(file->fd, page_data, PAGE_SIZE, offset);
+  free(bounce);
   // check for I/O error
-  if (db_io_.bad()) {
+  if (write_count != PAGE_SIZE) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  UpdateFileSize(file, offset + PAGE_SIZE);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  DataFile *file = FileOf(page_id);
+  off_t offset = PageOffset(page_id);
+  const char *mapped = GetMappedPage(page_id);
+  if (mapped != nullptr) {
+    memcpy(page_data, mapped, PAGE_SIZE);
+    return;
+  }
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (file == nullptr || offset > file->size) {
     LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  char *buf = page_data;
+  if (NeedsBounceBuffer(page_data) &&
+      posix_memalign(reinterpret_cast<void **>(&buf), DIRECT_IO_ALIGNMENT,
+                     PAGE_SIZE) != 0) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  ssize_t read_count = pread(file->fd, buf, PAGE_SIZE, offset);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    read_count = 0;
+  }
+  if (buf != page_data) {
+    memcpy(page_data, buf, read_count);
+    free(buf);
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Queue an asynchronous write of the specified page. The base disk manager has
+ * no asynchronous backend, so the write is done right away and the returned
+ * future is already satisfied
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id,
+                                              const char *page_data) {
+  std::promise<void> done;
+  WritePage(page_id, page_data);
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Queue an asynchronous read of the specified page (see WritePageAsync)
+ */
+std::future<void> DiskManager::ReadPageAsync(page_id_t page_id,
+                                             char *page_data) {
+  std::promise<void> done;
+  ReadPage(page_id, page_data);
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Write the contents of the contiguous pages [page_id, page_id + count) with as
+ * few system calls as possible
+ */
+void DiskManager::WritePages(page_id_t page_id, int count,
+                             const char *const *pages) {
+  if (IsReadOnly()) {
+    LOG_DEBUG("write to a read-only database");
+    return;
+  }
+  // group boundaries are tablespace boundaries, so runs stay in one file
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr) {
+    LOG_DEBUG("page %" PRId64 " is in no tablespace", page_id);
+    return;
+  }
+  std::vector<struct iovec> iov;
+  for (int done = 0; done < count;) {
+    int run = RunLength(page_id + done, count - done);
+    iov.clear();
+    for (int i = done; i < done + run; i++) {
+      if (NeedsBounceBuffer(pages[i]))
+        break;
+      iov.push_back(
+          {const_cast<char *>(pages[i]), static_cast<size_t>(PAGE_SIZE)});
     }
+    if (static_cast<int>(iov.size()) < run) {
+      // unaligned buffer for O_DIRECT, write the pages one by one
+      for (int i = done; i < done + run; i++)
+        WritePage(page_id + i, pages[i]);
+      done += run;
+      continue;
+    }
+    off_t offset = PageOffset(page_id + done);
+    ssize_t write_count = pwritev(file->fd, iov.data(), run, offset);
+    // check for I/O error
+    if (write_count != static_cast<ssize_t>(run) * PAGE_SIZE) {
+      LOG_DEBUG("I/O error while writing");
+    }
+    if (write_count > 0)
+      UpdateFileSize(file, offset + write_count);
+    done += run;
+  }
+}
+
+/**
+ * Read the contiguous pages [page_id, page_id + count) into the given memory
+ * areas with as few system calls as possible
+ */
+void DiskManager::ReadPages(page_id_t page_id, int count, char **pages) {
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr || file->map != nullptr) {
+    for (int i = 0; i < count; i++)
+      ReadPage(page_id + i, pages[i]);
+    return;
+  }
+  std::vector<struct iovec> iov;
+  for (int done = 0; done < count;) {
+    int run = RunLength(page_id + done, count - done);
+    iov.clear();
+    for (int i = done; i < done + run; i++) {
+      if (NeedsBounceBuffer(pages[i]))
+        break;
+      iov.push_back({pages[i], static_cast<size_t>(PAGE_SIZE)});
+    }
+    if (static_cast<int>(iov.size()) < run) {
+      // unaligned buffer for O_DIRECT, read the pages one by one
+      for (int i = done; i < done + run; i++)
+        ReadPage(page_id + i, pages[i]);
+      done += run;
+      continue;
+    }
+    ssize_t read_count =
+        preadv(file->fd, iov.data(), run, PageOffset(page_id + done));
+    if (read_count < 0) {
+      LOG_DEBUG("I/O error while reading");
+      read_count = 0;
+    }
+    // pages beyond the end of file are read as zeros
+    for (int i = read_count / PAGE_SIZE; i < run; i++) {
+      int valid = i == read_count / PAGE_SIZE ? read_count % PAGE_SIZE : 0;
+      memset(pages[done + i] + valid, 0, PAGE_SIZE - valid);
+    }
+    done += run;
   }
 }
 
@@ -138,7 +367,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
+bool DiskManager::ReadLog(char *log_data, int size, off_t offset) {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -156,18 +385,183 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
   return true;
 }
 
+/**
+ * Add a data file as a new tablespace, it is created if it doesn't exist. The
+ * tablespace is recorded in the header of the database file, so it's opened
+ * again with the database. Adding a data file twice returns the same id
+ * @return: id of the tablespace, or -1 on error
+ */
+int DiskManager::AddTablespace(const std::string &file_name) {
+  if (IsReadOnly()) {
+    LOG_DEBUG("add a tablespace to a read-only database");
+    return -1;
+  }
+  std::lock_guard<std::mutex> guard(tablespace_latch_);
+  int tablespace = num_tablespaces_;
+  for (int i = 0; i < tablespace; i++) {
+    if (files_[i]->name == file_name)
+      return i;
+  }
+  if (tablespace == MAX_TABLESPACES ||
+      HeaderSize(tablespace) + file_name.size() + 1 >
+          static_cast<size_t>(PAGE_SIZE)) {
+    LOG_DEBUG("too many tablespaces");
+    return -1;
+  }
+  DataFile *file = new DataFile;
+  file->name = file_name;
+  if (!OpenDataFile(file, PAGE_SIZE, nullptr)) {
+    if (file->fd >= 0)
+      close(file->fd);
+    delete file;
+    return -1;
+  }
+  files_[tablespace] = file;
+  num_tablespaces_ = tablespace + 1;
+  WriteHeader(files_[0], PAGE_SIZE);
+  return tablespace;
+}
+
+/**
+ * Returns number of tablespaces, including the database file
+ */
+int DiskManager::GetNumTablespaces() const { return num_tablespaces_; }
+
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Pages of one object are kept together in extents of EXTENT_SIZE pages when
+ * the caller passes the id of one of its pages. Without a hint, return the
+ * lowest free page id of the tablespace (see TablespaceHint). Either way the
+ * data file is only extended (a chunk of PREALLOCATE_PAGES at a time) when
+ * there is no deallocated page to reuse
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(page_id_t near_page_id) {
+  if (IsReadOnly()) {
+    LOG_DEBUG("allocate a page in a read-only database");
+    return INVALID_PAGE_ID;
+  }
+  int tablespace =
+      near_page_id < 0 ? -1 - near_page_id : TablespaceOf(near_page_id);
+  DataFile *file = GetFile(tablespace);
+  if (file == nullptr || file->fd < 0) {
+    LOG_DEBUG("no tablespace %d", tablespace);
+    return INVALID_PAGE_ID;
+  }
+  std::lock_guard<std::mutex> guard(file->alloc_latch);
+  page_id_t page_id; // local to the tablespace
+  int bit;
+  if (near_page_id < 0) {
+    size_t group = file->next_page_id / BITMAP_PAGE_BITS;
+    int from = file->next_page_id % BITMAP_PAGE_BITS;
+    while (group < MAX_GROUPS &&
+           !FindFreePage(file, group, from, BITMAP_PAGE_BITS, bit)) {
+      group++;
+      from = 0;
+    }
+    page_id = group < MAX_GROUPS ? group * BITMAP_PAGE_BITS + bit
+                                 : INVALID_PAGE_ID;
+  } else {
+    page_id_t local_page_id = LocalPageId(near_page_id);
+    size_t group = local_page_id / BITMAP_PAGE_BITS;
+    int from = local_page_id % BITMAP_PAGE_BITS;
+    from -= from % EXTENT_SIZE;
+    if (FindFreePage(file, group, from, from + EXTENT_SIZE, bit))
+      page_id = group * BITMAP_PAGE_BITS + bit;
+    else
+      page_id = FindEmptyExtent(file);
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    LOG_DEBUG("tablespace %d is full", tablespace);
+    return INVALID_PAGE_ID;
+  }
+  size_t group = page_id / BITMAP_PAGE_BITS;
+  SetBit(file->bitmaps[group], page_id % BITMAP_PAGE_BITS);
+  WriteBitmap(file, group);
+  if (near_page_id < 0) {
+    file->next_page_id = page_id + 1;
+    Preallocate(file, PageOffset(page_id) + PAGE_SIZE);
+  } else {
+    // reserve the whole extent
+    page_id_t last = page_id - page_id % EXTENT_SIZE + EXTENT_SIZE - 1;
+    Preallocate(file, PageOffset(last) + PAGE_SIZE);
+  }
+  return MakePageId(tablespace, page_id);
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * Mark the page as free in its bitmap page, so that it can be reused
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (IsReadOnly()) {
+    LOG_DEBUG("deallocate a page in a read-only database");
+    return;
+  }
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr) {
+    LOG_DEBUG("deallocate a free page %" PRId64, page_id);
+    return;
+  }
+  std::lock_guard<std::mutex> guard(file->alloc_latch);
+  page_id_t local_page_id = LocalPageId(page_id);
+  size_t group = local_page_id / BITMAP_PAGE_BITS;
+  int bit = local_page_id % BITMAP_PAGE_BITS;
+  if (group >= file->bitmaps.size() || !TestBit(file->bitmaps[group], bit)) {
+    LOG_DEBUG("deallocate a free page %" PRId64, page_id);
+    return;
+  }
+  ClearBit(file->bitmaps[group], bit);
+  WriteBitmap(file, group);
+  if (local_page_id < file->next_page_id)
+    file->next_page_id = local_page_id;
+}
+
+/**
+ * Return the page inside the mapping of a read-only database, or nullptr if
+ * the file is not mapped or ends before the page
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+const char *DiskManager::GetMappedPage(page_id_t page_id) const {
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr || file->map == nullptr)
+    return nullptr;
+  off_t offset = PageOffset(page_id);
+  if (offset + PAGE_SIZE > static_cast<off_t>(file->map_size))
+    return nullptr;
+  return file->map + offset;
+}
+
+/**
+ * Tell the kernel how the pages [page_id, page_id + count) are going to be
+ * accessed, or all the data files if page_id is INVALID_PAGE_ID. Uses madvise
+ * on the mapping of a read-only database and posix_fadvise otherwise
+ */
+void DiskManager::Advise(AccessPattern pattern, page_id_t page_id, int count) {
+  if (page_id == INVALID_PAGE_ID) {
+    // till the end of file
+    for (int i = 0; i < num_tablespaces_; i++)
+      AdviseFile(files_[i], pattern, 0, 0);
+    return;
+  }
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr)
+    return;
+  off_t offset = PageOffset(page_id);
+  off_t len = PageOffset(page_id + count - 1) + PAGE_SIZE - offset;
+  AdviseFile(file, pattern, offset, len);
+}
+
+/**
+ * Returns true if the page is allocated
+ */
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  DataFile *file = FileOf(page_id);
+  if (file == nullptr)
+    return false;
+  std::lock_guard<std::mutex> guard(file->alloc_latch);
+  page_id_t local_page_id = LocalPageId(page_id);
+  size_t group = local_page_id / BITMAP_PAGE_BITS;
+  return group < file->bitmaps.size() &&
+         TestBit(file->bitmaps[group], local_page_id % BITMAP_PAGE_BITS);
 }
 
 /**
@@ -180,10 +574,323 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Remember that the data file now extends to at least "end" bytes
+ */
+void DiskManager::UpdateFileSize(DataFile *file, off_t end) {
+  off_t size = file->size;
+  while (size < end && !file->size.compare_exchange_weak(size, end))
+    ;
+}
+
+/**
+ * Private helper function to open a data file and load its bitmap pages. An
+ * empty file gets a header with the given page size, otherwise the header is
+ * checked, and for the database file (tablespaces != nullptr) its page size is
+ * taken over and the data files of the other tablespaces are returned
+ */
+bool DiskManager::OpenDataFile(DataFile *file, int page_size,
+                               std::vector<std::string> *tablespaces) {
+  // create the file if it does not exist
+  int open_flags = IsReadOnly() ? O_RDONLY : O_RDWR | O_CREAT;
+  if (IsDirectIO())
+    open_flags |= O_DIRECT;
+  file->fd = open(file->name.c_str(), open_flags, 0644);
+  if (file->fd < 0 && IsDirectIO()) {
+    // e.g. tmpfs does not support O_DIRECT. Pages are still bounced through
+    // aligned buffers if other data files use it
+    LOG_DEBUG("O_DIRECT not supported, fall back to buffered I/O");
+    if (file == files_[0])
+      flags_ &= ~DISK_DIRECT_IO;
+    file->fd = open(file->name.c_str(), open_flags & ~O_DIRECT, 0644);
+  }
+  if (file->fd < 0) {
+    LOG_DEBUG("can't open data file %s", file->name.c_str());
+    return false;
+  }
+  file->size = GetFileSize(file->name);
+  if (file->size <= 0) {
+    if (IsReadOnly())
+      return false;
+    if (tablespaces != nullptr && !ClaimPageSize(page_size)) {
+      close(file->fd);
+      file->fd = -1;
+      return false;
+    }
+    WriteHeader(file, page_size);
+  } else if (!ReadHeader(file, tablespaces)) {
+    // don't touch a file that we can't make sense of
+    close(file->fd);
+    file->fd = -1;
+    return false;
+  }
+  file->preallocated_end = file->size;
+  LoadBitmaps(file);
+  if (IsReadOnly())
+    OpenMapping(file);
+  return true;
+}
+
+/**
+ * Private helper function to map a data file of a read-only database into
+ * memory. Page reads fall back to pread if the file can't be mapped
+ */
+void DiskManager::OpenMapping(DataFile *file) {
+  void *map = mmap(nullptr, file->size, PROT_READ, MAP_SHARED, file->fd, 0);
+  if (map == MAP_FAILED) {
+    LOG_DEBUG("mmap failed: %s", strerror(errno));
+    return;
+  }
+  file->map = static_cast<char *>(map);
+  file->map_size = file->size;
+}
+
+/**
+ * Private helper function to read the header of an existing data file
+ */
+bool DiskManager::ReadHeader(DataFile *file,
+                             std::vector<std::string> *tablespaces) {
+  char *buf = AllocateAligned(MIN_PAGE_SIZE);
+  FileHeader header;
+  bool valid = pread(file->fd, buf, MIN_PAGE_SIZE, 0) == MIN_PAGE_SIZE;
+  memcpy(&header, buf, sizeof(header));
+  free(buf);
+  if (!valid || memcmp(header.magic, DB_FILE_MAGIC, sizeof(header.magic)) ||
+      !IsValidPageSize(header.page_size)) {
+    LOG_DEBUG("not a database file: %s", file->name.c_str());
+    return false;
+  }
+  int version = header.version == 0 ? 1 : header.version;
+  if (tablespaces == nullptr) {
+    if (static_cast<int>(header.page_size) != PAGE_SIZE ||
+        version != format_version_) {
+      LOG_DEBUG("page size or version of %s does not match",
+                file->name.c_str());
+      return false;
+    }
+    return true;
+  }
+  format_version_ = version;
+  if (version != DB_FORMAT_VERSION) {
+    // the pages of a version 1 file don't have the layout of the page
+    // classes anymore, they would be misread
+    LOG_DEBUG("%s has format version %d, only version %d can be opened",
+              file->name.c_str(), version, DB_FORMAT_VERSION);
+    return false;
+  }
+  if (!ClaimPageSize(header.page_size))
+    return false;
+  if (header.num_tablespaces == 0)
+    return true;
+
+  // the names take up the rest of the header page
+  buf = AllocateAligned(PAGE_SIZE);
+  valid = pread(file->fd, buf, PAGE_SIZE, 0) == PAGE_SIZE;
+  const char *name = buf + sizeof(FileHeader);
+  for (uint32_t i = 0; valid && i < header.num_tablespaces; i++) {
+    size_t len = strnlen(name, buf + PAGE_SIZE - name);
+    if (name + len == buf + PAGE_SIZE) {
+      valid = false;
+      break;
+    }
+    tablespaces->emplace_back(name, len);
+    name += len + 1;
+  }
+  free(buf);
+  if (!valid) {
+    LOG_DEBUG("corrupted tablespaces in %s", file->name.c_str());
+  }
+  return true;
+}
+
+/**
+ * Private helper function to set the global PAGE_SIZE for the database. Fails
+ * if another open database uses a different page size, the pages, buffer pools
+ * and log buffers of that database are sized by PAGE_SIZE
+ */
+bool DiskManager::ClaimPageSize(int page_size) {
+  std::lock_guard<std::mutex> lock(page_size_latch);
+  if (page_size_users > 0 && page_size != PAGE_SIZE) {
+    LOG_DEBUG("page size %d differs from page size %d of the open databases",
+              page_size, PAGE_SIZE);
+    return false;
+  }
+  PAGE_SIZE = page_size;
+  page_size_users++;
+  owns_page_size_ = true;
+  return true;
+}
+
+/**
+ * Private helper function to write the header of a data file. The header of the
+ * database file records the tablespaces
+ */
+void DiskManager::WriteHeader(DataFile *file, int page_size) {
+  char *buf = AllocateAligned(page_size);
+  FileHeader header;
+  memcpy(header.magic, DB_FILE_MAGIC, sizeof(header.magic));
+  header.version = DB_FORMAT_VERSION;
+  header.page_size = page_size;
+  header.num_tablespaces = 0;
+  if (file == files_[0]) {
+    char *name = buf + sizeof(FileHeader);
+    for (int i = 1; i < num_tablespaces_; i++) {
+      memcpy(name, files_[i]->name.c_str(), files_[i]->name.size() + 1);
+      name += files_[i]->name.size() + 1;
+    }
+    header.num_tablespaces = num_tablespaces_ - 1;
+  }
+  memcpy(buf, &header, sizeof(header));
+  if (pwrite(file->fd, buf, page_size, 0) == page_size) {
+    UpdateFileSize(file, page_size);
+  } else {
+    LOG_DEBUG("I/O error while writing");
+  }
+  free(buf);
+}
+
+/**
+ * Private helper function to return the size of the header of the database
+ * file with the names of its first num_tablespaces tablespaces
+ */
+size_t DiskManager::HeaderSize(int num_tablespaces) const {
+  size_t size = sizeof(FileHeader);
+  for (int i = 1; i < num_tablespaces; i++)
+    size += files_[i]->name.size() + 1;
+  return size;
+}
+
+/**
+ * Private helper function to give an access pattern hint for a range of a data
+ * file, len 0 means till the end of file
+ */
+void DiskManager::AdviseFile(DataFile *file, AccessPattern pattern,
+                             off_t offset, off_t len) {
+  if (file->map == nullptr) {
+    static const int fadvice[] = {POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL,
+                                  POSIX_FADV_RANDOM, POSIX_FADV_WILLNEED};
+    posix_fadvise(file->fd, offset, len, fadvice[pattern]);
+    return;
+  }
+  static const int madvice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM,
+                                MADV_WILLNEED};
+  if (offset >= static_cast<off_t>(file->map_size))
+    return;
+  if (len == 0 || offset + len > static_cast<off_t>(file->map_size))
+    len = file->map_size - offset;
+  // madvise wants the start aligned to the system page size
+  off_t align = offset % sysconf(_SC_PAGESIZE);
+  if (madvise(file->map + offset - align, len + align, madvice[pattern]) !=
+      0) {
+    LOG_DEBUG("madvise failed: %s", strerror(errno));
+  }
+}
+
+/**
+ * Private helper function to read the bitmap pages of an existing data file
+ */
+void DiskManager::LoadBitmaps(DataFile *file) {
+  if (file->size <= 0)
+    return;
+  // not counting the header
+  off_t num_slots = (file->size + PAGE_SIZE - 1) / PAGE_SIZE - 1;
+  size_t num_groups = (num_slots + BITMAP_PAGE_BITS) / (BITMAP_PAGE_BITS + 1);
+  for (size_t group = 0; group < num_groups; group++) {
+    char *bitmap = AllocateBitmap();
+    if (pread(file->fd, bitmap, PAGE_SIZE, BitmapOffset(group)) < 0) {
+      LOG_DEBUG("I/O error while reading bitmap page");
+      memset(bitmap, 0, PAGE_SIZE);
+    }
+    file->bitmaps.push_back(bitmap);
+  }
+}
+
+/**
+ * Private helper function to persist a bitmap page. Caller must hold the
+ * alloc_latch of the file
+ */
+void DiskManager::WriteBitmap(DataFile *file, size_t group) {
+  off_t offset = BitmapOffset(group);
+  if (pwrite(file->fd, file->bitmaps[group], PAGE_SIZE, offset) !=
+      PAGE_SIZE) {
+    LOG_DEBUG("I/O error while writing bitmap page");
+    return;
+  }
+  UpdateFileSize(file, offset + PAGE_SIZE);
+}
+
+/**
+ * Private helper function to reserve disk space up to at least "end" bytes,
+ * PREALLOCATE_PAGES at a time. Caller must hold the alloc_latch of the file
+ */
+void DiskManager::Preallocate(DataFile *file, off_t end) {
+  if (end <= file->preallocated_end)
+    return;
+  off_t chunk = static_cast<off_t>(PREALLOCATE_PAGES) * PAGE_SIZE;
+  off_t new_end = std::max(end, file->preallocated_end + chunk);
+  // keep the file size, so it still tells how far pages have been written
+  if (fallocate(file->fd, FALLOC_FL_KEEP_SIZE, file->preallocated_end,
+                new_end - file->preallocated_end) != 0) {
+    LOG_DEBUG("fallocate failed: %s", strerror(errno));
+  }
+  file->preallocated_end = new_end;
+}
+
+/**
+ * Private helper function to find the first free page in bits [from, to) of a
+ * group's bitmap, the group is added if it doesn't exist yet. Caller must
+ * hold the alloc_latch of the file
+ */
+bool DiskManager::FindFreePage(DataFile *file, size_t group, int from, int to,
+                               int &bit) {
+  while (group >= file->bitmaps.size())
+    file->bitmaps.push_back(AllocateBitmap());
+  char *bitmap = file->bitmaps[group];
+  bit = from;
+  while (bit < to && TestBit(bitmap, bit)) {
+    // skip a whole byte of allocated pages at once
+    if (bit % 8 == 0 && bitmap[bit / 8] == static_cast<char>(0xFF))
+      bit += 8;
+    else
+      bit++;
+  }
+  return bit < to;
+}
+
+/**
+ * Private helper function to return the first local page of the first extent
+ * that has no allocated page, or INVALID_PAGE_ID if the tablespace is full.
+ * Caller must hold the alloc_latch of the file
+ */
+page_id_t DiskManager::FindEmptyExtent(DataFile *file) {
+  for (size_t group = 0; group < MAX_GROUPS; group++) {
+    if (group == file->bitmaps.size())
+      file->bitmaps.push_back(AllocateBitmap());
+    const char *bitmap = file->bitmaps[group];
+    for (int bit = 0; bit < BITMAP_PAGE_BITS; bit += EXTENT_SIZE) {
+      const char *bytes = bitmap + bit / 8;
+      if (std::all_of(bytes, bytes + EXTENT_SIZE / 8,
+                      [](char byte) { return byte == 0; }))
+        return group * BITMAP_PAGE_BITS + bit;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+/**
+ * Private helper function to return how many of the pages starting at page_id
+ * can be transferred with one vectored I/O (they must be adjacent in the file)
+ */
+int DiskManager::RunLength(page_id_t page_id, int count) {
+  int run = std::min(count, IOV_MAX);
+  return std::min(run, static_cast<int>(BITMAP_PAGE_BITS -
+                                        page_id % BITMAP_PAGE_BITS));
+}
+
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+off_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
@@ -0,0 +1,308 @@
+/**
+ * io_scheduler.cpp
+ */
+#include <algorithm>
+#include <cstring>
+
+#include "disk/io_scheduler.h"
+
+namespace cmudb {
+
+/**
+ * Constructor: start the worker threads. Reads may use all the workers, while
+ * writes and prefetches leave some of them for the reads to come
+ */
+IOScheduler::IOScheduler(DiskManager *disk_manager, int num_workers)
+    : disk_manager_(disk_manager), queued_writes_(),
+      write_cursor_(INVALID_PAGE_ID), queue_depth_(), in_flight_(),
+      num_writes_(0), shutdown_(false) {
+  num_workers = std::max(num_workers, 1);
+  queue_depth_[IO_PRIORITY_LOG] = 1;
+  queue_depth_[IO_PRIORITY_READ] = num_workers;
+  queue_depth_[IO_PRIORITY_WRITE] = std::max(num_workers / 2, 1);
+  queue_depth_[IO_PRIORITY_PREFETCH] = 1;
+  for (int i = 0; i < num_workers; i++)
+    workers_.emplace_back(&IOScheduler::WorkerThread, this);
+}
+
+/**
+ * Destructor: finish all the queued requests, then stop the workers
+ */
+IOScheduler::~IOScheduler() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    shutdown_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &worker : workers_)
+    worker.join();
+}
+
+/**
+ * Queue a read of the specified page
+ */
+std::future<void> IOScheduler::ReadPage(page_id_t page_id, char *page_data,
+                                        IOPriority priority) {
+  Request *req = new Request;
+  req->page_id = page_id;
+  req->count = 1;
+  req->pages = nullptr;
+  req->data = page_data;
+  std::future<void> f = req->done.get_future();
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (CopyPendingWrite(page_id, page_data)) {
+      // no need to go to the disk
+      req->done.set_value();
+      delete req;
+      return f;
+    }
+    queues_[priority].push_back(req);
+  }
+  work_cv_.notify_one();
+  return f;
+}
+
+/**
+ * Queue a read of the contiguous pages [page_id, page_id + count)
+ */
+std::future<void> IOScheduler::ReadPages(page_id_t page_id, int count,
+                                         char **pages, IOPriority priority,
+                                         std::function<void()> on_done) {
+  Request *req = new Request;
+  req->page_id = page_id;
+  req->count = count;
+  req->pages = pages;
+  req->data = nullptr;
+  req->on_done = std::move(on_done);
+  std::future<void> f = req->done.get_future();
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    queues_[priority].push_back(req);
+  }
+  work_cv_.notify_one();
+  return f;
+}
+
+/**
+ * Queue a write of the specified page. If the page is already waiting to be
+ * written, its queued image is replaced and both writers are notified once
+ * the new image is on disk
+ */
+std::future<void> IOScheduler::WritePage(page_id_t page_id,
+                                         const char *page_data,
+                                         IOPriority priority) {
+  std::promise<void> done;
+  std::future<void> f = done.get_future();
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    auto it = writes_.find(page_id);
+    // the old image is being written, the new one has to go after it
+    while (it != writes_.end() && it->second.in_flight) {
+      write_cv_.wait(lock);
+      it = writes_.find(page_id);
+    }
+    if (it == writes_.end()) {
+      PendingWrite &write = writes_[page_id];
+      write.data = page_data;
+      write.priority = priority;
+      write.in_flight = false;
+      write.done.push_back(std::move(done));
+      queued_writes_[priority]++;
+    } else {
+      PendingWrite &write = it->second;
+      write.data = page_data;
+      write.done.push_back(std::move(done));
+      if (priority < write.priority) {
+        // someone is waiting for it now
+        queued_writes_[write.priority]--;
+        queued_writes_[priority]++;
+        write.priority = priority;
+      }
+    }
+  }
+  work_cv_.notify_one();
+  return f;
+}
+
+/**
+ * Queue a write of the log data, after the log data queued before
+ */
+std::future<void> IOScheduler::WriteLog(char *log_data, int size) {
+  Request *req = new Request;
+  req->page_id = INVALID_PAGE_ID;
+  req->count = size;
+  req->pages = nullptr;
+  req->data = log_data;
+  std::future<void> f = req->done.get_future();
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    queues_[IO_PRIORITY_LOG].push_back(req);
+  }
+  work_cv_.notify_one();
+  return f;
+}
+
+void IOScheduler::SetQueueDepth(IOPriority priority, int depth) {
+  if (priority == IO_PRIORITY_LOG)
+    return;
+  std::lock_guard<std::mutex> guard(latch_);
+  queue_depth_[priority] = std::max(depth, 1);
+  work_cv_.notify_all();
+}
+
+int IOScheduler::GetQueueDepth(IOPriority priority) {
+  std::lock_guard<std::mutex> guard(latch_);
+  return queue_depth_[priority];
+}
+
+/*****************************************************************************
+ * HELPER METHODS
+ *****************************************************************************/
+/*
+ * Dispatch requests until the scheduler is shut down and there is nothing
+ * left to do
+ */
+void IOScheduler::WorkerThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    int priority = PickClass();
+    if (priority < 0) {
+      bool idle = writes_.empty() &&
+                  std::all_of(queues_, queues_ + NUM_IO_PRIORITIES,
+                              [](const std::deque<Request *> &queue) {
+                                return queue.empty();
+                              });
+      if (shutdown_ && idle)
+        return;
+      work_cv_.wait(lock);
+      continue;
+    }
+    in_flight_[priority]++;
+    if (!queues_[priority].empty()) {
+      Request *req = queues_[priority].front();
+      queues_[priority].pop_front();
+      Dispatch(lock, req);
+    } else {
+      DispatchWrites(lock, priority);
+    }
+    in_flight_[priority]--;
+    // a slot of the class is free again
+    work_cv_.notify_one();
+  }
+}
+
+/*
+ * Return the most urgent class that has work and is below its queue depth,
+ * or -1. Caller must hold latch_
+ */
+int IOScheduler::PickClass() {
+  for (int priority = 0; priority < NUM_IO_PRIORITIES; priority++) {
+    if (in_flight_[priority] >= queue_depth_[priority])
+      continue;
+    if (!queues_[priority].empty() || queued_writes_[priority] > 0)
+      return priority;
+  }
+  return -1;
+}
+
+/*
+ * Perform a read or log write without holding latch_. Pages that are waiting
+ * to be written are copied from their image instead. Caller must hold latch_
+ */
+void IOScheduler::Dispatch(std::unique_lock<std::mutex> &lock,
+                           Request *req) {
+  if (req->page_id == INVALID_PAGE_ID) {
+    lock.unlock();
+    disk_manager_->WriteLog(req->data, req->count);
+  } else if (req->pages == nullptr) {
+    if (CopyPendingWrite(req->page_id, req->data)) {
+      req->done.set_value();
+      delete req;
+      return;
+    }
+    lock.unlock();
+    disk_manager_->ReadPage(req->page_id, req->data);
+  } else {
+    std::vector<bool> copied(req->count);
+    for (int i = 0; i < req->count; i++)
+      copied[i] = CopyPendingWrite(req->page_id + i, req->pages[i]);
+    lock.unlock();
+    for (int i = 0; i < req->count;) {
+      if (copied[i]) {
+        i++;
+        continue;
+      }
+      int run = 1;
+      while (i + run < req->count && !copied[i + run])
+        run++;
+      disk_manager_->ReadPages(req->page_id + i, run, req->pages + i);
+      i += run;
+    }
+  }
+  if (req->on_done)
+    req->on_done();
+  req->done.set_value();
+  delete req;
+  lock.lock();
+}
+
+/*
+ * Write the first queued page of the class at or after the cursor together
+ * with the queued pages right after it, with one vectored I/O. Caller must
+ * hold latch_
+ */
+void IOScheduler::DispatchWrites(std::unique_lock<std::mutex> &lock,
+                                 int priority) {
+  auto is_ready = [priority](const std::pair<const page_id_t, PendingWrite> &w) {
+    return !w.second.in_flight && w.second.priority == priority;
+  };
+  auto first = std::find_if(writes_.lower_bound(write_cursor_), writes_.end(),
+                            is_ready);
+  if (first == writes_.end()) {
+    // wrap around
+    first = std::find_if(writes_.begin(), writes_.end(), is_ready);
+  }
+  page_id_t page_id = first->first;
+  std::vector<const char *> pages;
+  for (auto it = first; it != writes_.end() && !it->second.in_flight &&
+                        it->first == page_id + static_cast<int>(pages.size()) &&
+                        pages.size() < MAX_COALESCED_PAGES;
+       ++it) {
+    it->second.in_flight = true;
+    queued_writes_[it->second.priority]--;
+    pages.push_back(it->second.data);
+  }
+  int count = pages.size();
+  write_cursor_ = page_id + count;
+
+  lock.unlock();
+  if (count == 1)
+    disk_manager_->WritePage(page_id, pages[0]);
+  else
+    disk_manager_->WritePages(page_id, count, pages.data());
+  num_writes_++;
+  lock.lock();
+
+  for (int i = 0; i < count; i++) {
+    auto it = writes_.find(page_id + i);
+    for (auto &done : it->second.done)
+      done.set_value();
+    writes_.erase(it);
+  }
+  write_cv_.notify_all();
+}
+
+/*
+ * Copy the image of a page that is waiting to be written, if any. Caller must
+ * hold latch_
+ */
+bool IOScheduler::CopyPendingWrite(page_id_t page_id, char *page_data) {
+  auto it = writes_.find(page_id);
+  if (it == writes_.end())
+    return false;
+  memcpy(page_data, it->second.data, PAGE_SIZE);
+  return true;
+}
+
+} // namespace cmudb
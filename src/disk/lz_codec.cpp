@@ -0,0 +1,144 @@
+/**
+ * lz_codec.cpp
+ */
+#include <cstdint>
+#include <cstring>
+
+#include "disk/lz_codec.h"
+
+namespace cmudb {
+
+static inline uint32_t Read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t Hash(uint32_t seq) {
+  return (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// write the extra length bytes of a length that didn't fit into the token
+static inline uint8_t *WriteLength(uint8_t *op, int len) {
+  for (len -= 15; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = static_cast<uint8_t>(len);
+  return op;
+}
+
+static inline bool ReadLength(const uint8_t *&ip, const uint8_t *end,
+                              int &len) {
+  if (len != 15)
+    return true;
+  uint8_t byte;
+  do {
+    if (ip == end)
+      return false;
+    byte = *ip++;
+    len += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/*
+ * append one sequence, match_len is 0 for the last one. Return nullptr if
+ * out of space
+ */
+static uint8_t *WriteSequence(uint8_t *op, uint8_t *end, const uint8_t *lit,
+                              int lit_len, int offset, int match_len) {
+  int match_code = match_len > 0 ? match_len - LZ_MIN_MATCH : 0;
+  int need = 1 + lit_len + (lit_len >= 15 ? (lit_len - 15) / 255 + 1 : 0);
+  if (match_len > 0)
+    need += 2 + (match_code >= 15 ? (match_code - 15) / 255 + 1 : 0);
+  if (end - op < need)
+    return nullptr;
+  uint8_t *token = op++;
+  *token = static_cast<uint8_t>((lit_len < 15 ? lit_len : 15) << 4);
+  if (lit_len >= 15)
+    op = WriteLength(op, lit_len);
+  memcpy(op, lit, lit_len);
+  op += lit_len;
+  if (match_len == 0)
+    return op;
+  *op++ = static_cast<uint8_t>(offset & 0xFF);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  *token |= static_cast<uint8_t>(match_code < 15 ? match_code : 15);
+  if (match_code >= 15)
+    op = WriteLength(op, match_code);
+  return op;
+}
+
+int LZCodec::Compress(const char *src, int size, char *dst, int capacity) {
+  const uint8_t *in = reinterpret_cast<const uint8_t *>(src);
+  uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *end = op + capacity;
+  // last position + 1 where a sequence was seen, 0 means none
+  int table[1 << LZ_HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  int anchor = 0; // first byte not encoded yet
+  int pos = 0;
+  while (pos + LZ_MIN_MATCH <= size) {
+    uint32_t seq = Read32(in + pos);
+    uint32_t h = Hash(seq);
+    int candidate = table[h] - 1;
+    table[h] = pos + 1;
+    if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET ||
+        Read32(in + candidate) != seq) {
+      pos++;
+      continue;
+    }
+    int match_len = LZ_MIN_MATCH;
+    while (pos + match_len < size &&
+           in[candidate + match_len] == in[pos + match_len])
+      match_len++;
+    op = WriteSequence(op, end, in + anchor, pos - anchor, pos - candidate,
+                       match_len);
+    if (op == nullptr)
+      return 0;
+    pos += match_len;
+    anchor = pos;
+  }
+  op = WriteSequence(op, end, in + anchor, size - anchor, 0, 0);
+  if (op == nullptr)
+    return 0;
+  return static_cast<int>(op - reinterpret_cast<uint8_t *>(dst));
+}
+
+int LZCodec::Decompress(const char *src, int size, char *dst, int capacity) {
+  const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *in_end = ip + size;
+  uint8_t *out = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op = out;
+  uint8_t *out_end = out + capacity;
+  while (ip < in_end) {
+    uint8_t token = *ip++;
+    int lit_len = token >> 4;
+    if (!ReadLength(ip, in_end, lit_len) || in_end - ip < lit_len ||
+        out_end - op < lit_len)
+      return -1;
+    memcpy(op, ip, lit_len);
+    ip += lit_len;
+    op += lit_len;
+    if (ip == in_end)
+      break; // the last sequence has no match
+    if (in_end - ip < 2)
+      return -1;
+    int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    int match_len = token & 0xF;
+    if (!ReadLength(ip, in_end, match_len))
+      return -1;
+    match_len += LZ_MIN_MATCH;
+    if (offset == 0 || offset > op - out || out_end - op < match_len)
+      return -1;
+    // byte by byte, the match may overlap with what it produces
+    const uint8_t *match = op - offset;
+    for (int i = 0; i < match_len; i++)
+      op[i] = match[i];
+    op += match_len;
+  }
+  return static_cast<int>(op - out);
+}
+
+} // namespace cmudb
@@ -0,0 +1,322 @@
+/**
+ * uring_disk_manager.cpp
+ */
+#include <cassert>
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/uring_disk_manager.h"
+
+namespace cmudb {
+
+/*
+ * thin wrappers around the io_uring system calls (no liburing dependency)
+ */
+static int uring_setup(unsigned entries, io_uring_params *p) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+/**
+ * Constructor: open the database file and set up a ring of queue_depth
+ * entries. Falls back to synchronous I/O if the ring can't be set up
+ */
+UringDiskManager::UringDiskManager(const std::string &db_file, int flags,
+                                   unsigned queue_depth)
+    : DiskManager(db_file, flags), ring_fd_(-1), sq_ring_(MAP_FAILED),
+      sqes_(nullptr), cq_ring_(MAP_FAILED), to_submit_(0), in_flight_(0),
+      completion_thread_(nullptr) {
+  if (GetFile(0)->fd < 0)
+    return;
+  if (!SetupRing(queue_depth)) {
+    LOG_DEBUG("io_uring unavailable, using synchronous page I/O");
+    return;
+  }
+  completion_thread_ =
+      new std::thread(&UringDiskManager::CompletionThread, this);
+}
+
+UringDiskManager::~UringDiskManager() {
+  if (IsAsync()) {
+    {
+      // drain all the outstanding requests, then tell the completion thread
+      // to exit with a nop whose user_data is null
+      std::unique_lock<std::mutex> lock(sq_latch_);
+      SubmitLocked();
+      while (in_flight_ > 0)
+        cq_space_.wait(lock);
+      io_uring_sqe *sqe = GetSqe();
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = 0;
+      SubmitLocked();
+    }
+    completion_thread_->join();
+    delete completion_thread_;
+    munmap(sqes_, sqes_size_);
+    munmap(cq_ring_, cq_ring_size_);
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+  }
+}
+
+/**
+ * Write the contents of the specified page into disk file, and wait for it
+ */
+void UringDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  if (!IsAsync()) {
+    DiskManager::WritePage(page_id, page_data);
+    return;
+  }
+  std::future<void> f = WritePageAsync(page_id, page_data);
+  SubmitBatch();
+  f.wait();
+}
+
+/**
+ * Read the contents of the specified page into the given memory area, and
+ * wait for it
+ */
+void UringDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  if (!IsAsync()) {
+    DiskManager::ReadPage(page_id, page_data);
+    return;
+  }
+  std::future<void> f = ReadPageAsync(page_id, page_data);
+  SubmitBatch();
+  f.wait();
+}
+
+/**
+ * Queue a write of the specified page. page_data must stay valid until the
+ * returned future is satisfied
+ */
+std::future<void> UringDiskManager::WritePageAsync(page_id_t page_id,
+                                                   const char *page_data) {
+  if (!IsAsync())
+    return DiskManager::WritePageAsync(page_id, page_data);
+  return Enqueue(IORING_OP_WRITE, page_id, const_cast<char *>(page_data));
+}
+
+/**
+ * Queue a read of the specified page. Reading beyond the end of file fills the
+ * page with zeros
+ */
+std::future<void> UringDiskManager::ReadPageAsync(page_id_t page_id,
+                                                  char *page_data) {
+  if (!IsAsync())
+    return DiskManager::ReadPageAsync(page_id, page_data);
+  return Enqueue(IORING_OP_READ, page_id, page_data);
+}
+
+/**
+ * Hand all the queued requests to the kernel with a single system call
+ */
+void UringDiskManager::SubmitBatch() {
+  if (!IsAsync())
+    return;
+  std::lock_guard<std::mutex> guard(sq_latch_);
+  SubmitLocked();
+}
+
+/*****************************************************************************
+ * HELPER METHODS
+ *****************************************************************************/
+bool UringDiskManager::SetupRing(unsigned queue_depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = uring_setup(queue_depth, &params);
+  if (fd < 0)
+    return false;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+    if (sq_ring_ != MAP_FAILED)
+      munmap(sq_ring_, sq_ring_size_);
+    if (cq_ring_ != MAP_FAILED)
+      munmap(cq_ring_, cq_ring_size_);
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqes_size_);
+    close(fd);
+    return false;
+  }
+
+  char *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  sq_entries_ = params.sq_entries;
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  char *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  ring_fd_ = fd;
+  return true;
+}
+
+std::future<void> UringDiskManager::Enqueue(int opcode, page_id_t page_id,
+                                            char *buf) {
+  Request *req = new Request;
+  req->read_buf = opcode == IORING_OP_READ ? buf : nullptr;
+  req->bounce = nullptr;
+  req->file = FileOf(page_id);
+  off_t offset = PageOffset(page_id);
+  req->end = offset + PAGE_SIZE;
+  std::future<void> f = req->done.get_future();
+  if (req->file == nullptr) {
+    LOG_DEBUG("page %" PRId64 " is in no tablespace", page_id);
+    Complete(req, -EBADF);
+    return f;
+  }
+  if (NeedsBounceBuffer(buf)) {
+    // O_DIRECT needs an aligned buffer, that lives until the completion
+    if (posix_memalign(reinterpret_cast<void **>(&req->bounce),
+                       DIRECT_IO_ALIGNMENT, PAGE_SIZE) != 0) {
+      req->bounce = nullptr;
+      LOG_DEBUG("I/O error on page %" PRId64, page_id);
+      Complete(req, -ENOMEM);
+      return f;
+    }
+    if (opcode == IORING_OP_WRITE)
+      memcpy(req->bounce, buf, PAGE_SIZE);
+    buf = req->bounce;
+  }
+
+  std::lock_guard<std::mutex> guard(sq_latch_);
+  io_uring_sqe *sqe = GetSqe();
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = static_cast<uint8_t>(opcode);
+  sqe->fd = req->file->fd;
+  sqe->off = static_cast<uint64_t>(offset);
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = PAGE_SIZE;
+  sqe->user_data = reinterpret_cast<uint64_t>(req);
+  return f;
+}
+
+/*
+ * Return the next free sqe and queue it locally. Submits what is queued and
+ * waits for completions when the ring is full. Caller must hold sq_latch_
+ */
+io_uring_sqe *UringDiskManager::GetSqe() {
+  if (to_submit_ + in_flight_ >= sq_entries_) {
+    std::unique_lock<std::mutex> lock(sq_latch_, std::adopt_lock);
+    SubmitLocked();
+    while (to_submit_ + in_flight_ >= sq_entries_)
+      cq_space_.wait(lock);
+    lock.release();
+  }
+  unsigned tail = *sq_tail_ + to_submit_;
+  unsigned index = tail & *sq_mask_;
+  sq_array_[index] = index;
+  to_submit_++;
+  return &sqes_[index];
+}
+
+/*
+ * Publish the locally queued sqes and enter the kernel. Caller must hold
+ * sq_latch_
+ */
+void UringDiskManager::SubmitLocked() {
+  if (to_submit_ == 0)
+    return;
+  __atomic_store_n(sq_tail_, *sq_tail_ + to_submit_, __ATOMIC_RELEASE);
+  unsigned pending = to_submit_;
+  to_submit_ = 0;
+  while (pending > 0) {
+    int ret = uring_enter(ring_fd_, pending, 0, 0);
+    if (ret < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      assert(false);
+      return;
+    }
+    pending -= ret;
+    in_flight_ += ret;
+  }
+}
+
+/*
+ * Reap completions and fulfill the futures of finished requests, until the
+ * shutdown nop (null user_data) comes back
+ */
+void UringDiskManager::CompletionThread() {
+  while (true) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+    bool stop = false;
+    unsigned reaped = 0;
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      Request *req = reinterpret_cast<Request *>(cqe->user_data);
+      reaped++;
+      if (req == nullptr) {
+        stop = true;
+        continue;
+      }
+      Complete(req, cqe->res);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    {
+      std::lock_guard<std::mutex> guard(sq_latch_);
+      in_flight_ -= reaped;
+    }
+    cq_space_.notify_all();
+    if (stop)
+      return;
+  }
+}
+
+/*
+ * Finish a request given the result of its read/write, and free it
+ */
+void UringDiskManager::Complete(Request *req, int res) {
+  if (res < 0) {
+    LOG_DEBUG("I/O error: %s", strerror(-res));
+    res = 0;
+  }
+  if (req->read_buf != nullptr) {
+    if (req->bounce != nullptr)
+      memcpy(req->read_buf, req->bounce, res);
+    // reading beyond the end of file
+    if (res < PAGE_SIZE)
+      memset(req->read_buf + res, 0, PAGE_SIZE - res);
+  } else if (res == PAGE_SIZE) {
+    UpdateFileSize(req->file, req->end);
+  }
+  free(req->bounce);
+  req->done.set_value();
+  delete req;
+}
+
+} // namespace cmudb
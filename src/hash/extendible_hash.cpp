@@ -12,7 +12,21 @@ namespace cmudb {
  */
 template<typename K, typename V>
 ExtendibleHash<K, V>::ExtendibleHash(size_t size): global_depth_(0), size_limit_(size) {
-    bucket_directory_.push_back(std::make_shared<Bucket>(0));
+    bucket_directory_.push_back(new Bucket(0));
+}
+
+/*
+ * destructor
+ * every bucket is deleted from the first slot of its prefix, which comes last
+ * going backwards
+ */
+template<typename K, typename V>
+ExtendibleHash<K, V>::~ExtendibleHash() {
+    for (size_t i = bucket_directory_.size(); i-- > 0;) {
+        if (i < (static_cast<size_t>(1) << bucket_directory_[i]->local_depth_)) {
+            delete bucket_directory_[i];
+        }
+    }
 }
 
 /*
@@ -29,7 +43,10 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) {
  */
 template<typename K, typename V>
 int ExtendibleHash<K, V>::GetGlobalDepth() const {
-    return global_depth_;
+    dir_latch_.RLock();
+    int depth = global_depth_;
+    dir_latch_.RUnlock();
+    return depth;
 }
 
 /*
@@ -38,7 +55,10 @@ int ExtendibleHash<K, V>::GetGlobalDepth() const {
  */
 template<typename K, typename V>
 int ExtendibleHash<K, V>::GetLocalDepth(int bucket_index) const {
-    return bucket_directory_[bucket_index]->local_depth_;
+    dir_latch_.RLock();
+    int depth = bucket_directory_[bucket_index]->local_depth_;
+    dir_latch_.RUnlock();
+    return depth;
 }
 
 /*
@@ -46,7 +66,10 @@ int ExtendibleHash<K, V>::GetLocalDepth(int bucket_index) const {
  */
 template<typename K, typename V>
 int ExtendibleHash<K, V>::GetNumBuckets() const {
-    return static_cast<int>(bucket_directory_.size());
+    dir_latch_.RLock();
+    int num_buckets = static_cast<int>(bucket_directory_.size());
+    dir_latch_.RUnlock();
+    return num_buckets;
 }
 
 /*
@@ -54,40 +77,67 @@ int ExtendibleHash<K, V>::GetNumBuckets() const {
  */
 template<typename K, typename V>
 bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-    std::lock_guard<std::mutex> guard(latch_);
-    std::shared_ptr<Bucket> bucket = GetBucket(key);
-    if (bucket->map_.find(key) == bucket->map_.end()) {
-        return false;
+    dir_latch_.RLock();
+    Bucket *bucket = GetBucket(key);
+    bucket->latch_.lock();
+    auto it = bucket->map_.find(key);
+    bool found = it != bucket->map_.end();
+    if (found) {
+        value = it->second;
     }
-    value = bucket->map_[key];
-    return true;
+    bucket->latch_.unlock();
+    dir_latch_.RUnlock();
+    return found;
 }
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * A bucket left empty is merged, with the directory latch taken exclusively
+ * after the shared one is released
  */
 template<typename K, typename V>
 bool ExtendibleHash<K, V>::Remove(const K &key) {
-    std::lock_guard<std::mutex> guard(latch_);
-    std::shared_ptr<Bucket> bucket = GetBucket(key);
-    if (bucket->map_.find(key) == bucket->map_.end()) {
-        return false;
+    dir_latch_.RLock();
+    Bucket *bucket = GetBucket(key);
+    bucket->latch_.lock();
+    bool removed = bucket->map_.erase(key) != 0;
+    bool emptied = removed && bucket->map_.empty() && bucket->local_depth_ > 0;
+    bucket->latch_.unlock();
+    dir_latch_.RUnlock();
+    if (emptied) {
+        dir_latch_.WLock();
+        Merge(key);
+        dir_latch_.WUnlock();
     }
-    bucket->map_.erase(key);
-    return true;
+    return removed;
 }
 
 /*
  * insert <key,value> entry in hash table
  * Split & Redistribute bucket when there is overflow and if necessary increase
- * global depth
+ * global depth. The split is done with the directory latch taken exclusively
+ * after the shared one is released, the bucket may have changed meanwhile
  */
 template<typename K, typename V>
 void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-    std::lock_guard<std::mutex> guard(latch_);
-    std::shared_ptr<Bucket> bucket = GetBucket(key);
-    while (bucket->map_.size() == size_limit_) {
+    dir_latch_.RLock();
+    Bucket *bucket = GetBucket(key);
+    bucket->latch_.lock();
+    bool done = bucket->map_.size() < size_limit_ ||
+                bucket->map_.count(key) != 0;
+    if (done) {
+        bucket->map_[key] = value;
+    }
+    bucket->latch_.unlock();
+    dir_latch_.RUnlock();
+    if (done) {
+        return;
+    }
+
+    dir_latch_.WLock();
+    bucket = GetBucket(key);
+    while (bucket->map_.size() >= size_limit_ &&
+           bucket->map_.count(key) == 0) {
         if (bucket->local_depth_ == global_depth_) {
             size_t length = bucket_directory_.size();
             for (size_t i = 0; i < length; i++){
@@ -96,8 +146,8 @@ void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
             global_depth_++;
         }
         int mask = 1 << bucket->local_depth_;
-        auto left_bucket = std::make_shared<Bucket>(bucket->local_depth_ + 1);
-        auto right_bucket = std::make_shared<Bucket>(bucket->local_depth_ + 1);
+        Bucket *left_bucket = new Bucket(bucket->local_depth_ + 1);
+        Bucket *right_bucket = new Bucket(bucket->local_depth_ + 1);
         for (auto item : bucket->map_){
             if (mask & HashKey(item.first)){
                 right_bucket->map_.insert(item);
@@ -114,9 +164,54 @@ void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
                 }
             }
         }
+        delete bucket;
         bucket = GetBucket(key);
     }
     bucket->map_[key] = value;
+    dir_latch_.WUnlock();
+}
+
+/*
+ * Merge the bucket of key with its split image (the bucket whose prefix only
+ * differs in the highest bit) while one of the two is empty and they have the
+ * same local depth, then halve the directory while no bucket needs all of its
+ * bits. Caller must hold dir_latch_ exclusively
+ */
+template<typename K, typename V>
+void ExtendibleHash<K, V>::Merge(const K &key) {
+    size_t index = GetBucketIndex(HashKey(key));
+    Bucket *bucket = bucket_directory_[index];
+    while (bucket->local_depth_ > 0) {
+        size_t image_index =
+            index ^ (static_cast<size_t>(1) << (bucket->local_depth_ - 1));
+        Bucket *image = bucket_directory_[image_index];
+        if (image->local_depth_ != bucket->local_depth_ ||
+            (!bucket->map_.empty() && !image->map_.empty())) {
+            break;
+        }
+        // keep the one that has entries
+        if (bucket->map_.empty()) {
+            std::swap(bucket, image);
+        }
+        bucket->local_depth_--;
+        for (size_t i = 0; i < bucket_directory_.size(); i++) {
+            if (bucket_directory_[i] == image) {
+                bucket_directory_[i] = bucket;
+            }
+        }
+        delete image;
+    }
+
+    while (global_depth_ > 0) {
+        for (auto slot : bucket_directory_) {
+            if (slot->local_depth_ == global_depth_) {
+                return;
+            }
+        }
+        // the upper half repeats the lower one
+        bucket_directory_.resize(bucket_directory_.size() / 2);
+        global_depth_--;
+    }
 }
 
 template<typename K, typename V>
@@ -124,10 +219,13 @@ int ExtendibleHash<K, V>::GetBucketIndex(size_t hash_value) const {
     return static_cast<int>(hash_value & ((1 << global_depth_) - 1));
 }
 
+/*
+ * Caller must hold dir_latch_
+ */
 template<typename K, typename V>
-std::shared_ptr<typename ExtendibleHash<K, V>::Bucket> ExtendibleHash<K, V>::GetBucket(const K &key) {
-    return bucket_directory_.at(GetBucketIndex(HashKey(key)));
-};
+typename ExtendibleHash<K, V>::Bucket *ExtendibleHash<K, V>::GetBucket(const K &key) {
+    return bucket_directory_[GetBucketIndex(HashKey(key))];
+}
 
 template class ExtendibleHash<page_id_t, Page *>;
 
@@ -0,0 +1,59 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * A bounded ring of the pages that a large scan brought into the buffer pool.
+ * Once the ring is full, the page that falls out of it is handed back to the
+ * free list of its instance, so the scan keeps recycling the same few frames
+ * instead of evicting everybody else's working set. Pages the scan finds in
+ * the pool already are not taken into the ring. The buffer pool keeps a ring
+ * to a fraction of its size, a ring as large as the pool would never recycle
+ * a frame. Not thread safe, every scan has its own.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+#define SCAN_RING_SIZE 32         // default number of frames of a scan
+#define SCAN_RING_POOL_FRACTION 4 // a ring takes at most 1/4 of the pool
+
+class BufferAccessStrategy {
+public:
+  explicit BufferAccessStrategy(size_t ring_size = SCAN_RING_SIZE)
+      : ring_size_(std::max<size_t>(ring_size, 1)) {}
+
+  // remember a page the scan loaded, return the page that falls out of the
+  // ring or INVALID_PAGE_ID
+  inline page_id_t Add(page_id_t page_id) {
+    ring_.push_back(page_id);
+    return Pop();
+  }
+
+  // return the oldest page while the ring holds more than its size, then
+  // INVALID_PAGE_ID
+  inline page_id_t Pop() {
+    if (ring_.size() <= ring_size_)
+      return INVALID_PAGE_ID;
+    page_id_t oldest = ring_.front();
+    ring_.pop_front();
+    return oldest;
+  }
+
+  // shrink the ring to at most max_ring_size frames
+  inline void Limit(size_t max_ring_size) {
+    ring_size_ = std::min(ring_size_, std::max<size_t>(max_ring_size, 1));
+  }
+
+  inline size_t GetRingSize() const { return ring_size_; }
+
+private:
+  size_t ring_size_;
+  std::deque<page_id_t> ring_; // oldest first
+};
+
+} // namespace cmudb
@@ -0,0 +1,197 @@
+/*
+ * buffer_pool_instance.h
+ *
+ * One partition of the buffer pool: its own frames, page table, replacer, free
+ * list and latch. BufferPoolManager hashes every page id to one instance, see
+ * buffer_pool_manager.h
+ *
+ * The latch only covers the metadata. Disk reads and write backs are done
+ * without it, the frame is marked as having I/O in progress meanwhile, so a
+ * page that is already cached is never held up by the I/O of another one.
+ *
+ * The frames come in chunks, so that the pool can grow and shrink online: a
+ * grow adds a chunk, a shrink evicts pages from the newest chunks and frees a
+ * chunk once none of its frames is in use anymore.
+ *
+ * With a compressed cache, the pages evicted from the instance are kept there
+ * and a miss looks there before reading the disk.
+ *
+ * Victims are taken from the replacer, passing over the pages fetched with a
+ * hint (see PageHint) as long as there are others, so that the upper levels
+ * of the indexes stay in memory.
+ *
+ * A page can also be pinned through a swizzled reference, the frame it was
+ * found in last time, without the latch and the page table: the pin is taken
+ * first and the frame checked after. A frame is only taken away from its page
+ * once it is seen unpinned with the page marked as not resident, so one of
+ * the two sides always notices the other. The metadata of the frames stays
+ * allocated until the instance is destroyed, even when a shrink frees a chunk.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "disk/disk_manager.h"
+#include "disk/io_scheduler.h"
+#include "hash/extendible_hash.h"
+#include "logging/log_manager.h"
+#include "page/page.h"
+
+namespace cmudb {
+class BufferPoolInstance {
+public:
+  // page I/O goes through io_scheduler if not nullptr. compressed_cache_size:
+  // bytes of the compressed cache of evicted pages, 0 for none
+  BufferPoolInstance(size_t pool_size, DiskManager *disk_manager,
+                     LogManager *log_manager = nullptr,
+                     IOScheduler *io_scheduler = nullptr,
+                     ReplacerPolicy policy = LRU_REPLACER,
+                     size_t compressed_cache_size = 0);
+
+  ~BufferPoolInstance();
+
+  // loaded: set to true if the page had to be loaded into the pool
+  Page *FetchPage(page_id_t page_id, bool *loaded = nullptr,
+                  PageHint hint = PAGE_HINT_NORMAL);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  // pin page_id if it is still in the frame page, nullptr if not
+  Page *FetchSwizzled(Page *page, page_id_t page_id);
+  // unpin a page by its frame, without the latch if the page stays clean
+  bool UnpinFrame(Page *page, bool is_dirty);
+
+  bool FlushPage(page_id_t page_id);
+
+  // a frame for a page that was just allocated on disk
+  Page *NewPage(page_id_t page_id, PageHint hint = PAGE_HINT_NORMAL);
+
+  // drop the page from the pool, false if it is pinned
+  bool DeletePage(page_id_t page_id);
+
+  // load [page_id, page_id + count) with large sequential reads, unpinned.
+  // The pages that were loaded are appended to loaded if not nullptr
+  void ReadAhead(page_id_t page_id, int count,
+                 std::vector<page_id_t> *loaded = nullptr);
+  // same, without waiting for the reads
+  void Prefetch(page_id_t page_id, int count,
+                std::vector<page_id_t> *loaded = nullptr);
+
+  // give the frame of the page back to the free list, if it is clean and
+  // unpinned
+  void ReleasePage(page_id_t page_id);
+
+  // free frames from the eviction end of the replacer, writing the dirty
+  // pages back, until free_frames frames are free. Return the pages written
+  size_t CleanFrames(size_t free_frames);
+
+  // grow or shrink the pool to pool_size pages (at least 1), writing back
+  // the dirty pages that are dropped. Pinned pages stay, so the pool may end
+  // up larger than asked. Return the new size
+  size_t Resize(size_t pool_size);
+
+  // append the ids of the pages in the pool, the most recently used first
+  void GetHotPages(std::vector<page_id_t> *page_ids);
+
+  // pages read from the compressed cache instead of the disk
+  inline size_t GetNumCacheHits() const {
+    return compressed_cache_ != nullptr ? compressed_cache_->GetNumHits() : 0;
+  }
+
+  inline size_t GetPoolSize() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return pool_size_;
+  }
+
+private:
+  // frames added to the pool at once
+  struct FrameChunk {
+    Page *pages;        // array of pages, cache line aligned
+    FrameArena *frames; // page data of the pages
+    size_t size;
+  };
+
+  size_t pool_size_; // number of pages in buffer pool, without retired ones
+  std::vector<FrameChunk> chunks_;
+  // frames taken out of the pool by a shrink, until their chunk is freed
+  std::unordered_set<Page *> retired_;
+  // page metadata of the freed chunks, swizzled references may point there
+  std::vector<FrameChunk> freed_chunks_;
+  ReplacerPolicy policy_;
+  DiskManager *disk_manager_;
+  LogManager *log_manager_;
+  IOScheduler *io_scheduler_;
+  CompressedCache *compressed_cache_; // nullptr if disabled
+  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
+  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+  std::list<Page *> *free_list_; // to find a free page for replacement
+  // pages being written back, by the frame that is then loaded with another
+  std::unordered_map<page_id_t, Page *> evicting_;
+  uint64_t use_count_; // pins so far, to order the pages by recency
+  size_t prefetching_; // pages being prefetched
+  std::condition_variable prefetch_done_;
+  std::mutex latch_; // to protect shared data structure
+  std::mutex resize_latch_; // one resize at a time
+
+  FrameChunk AllocateChunk(size_t size);
+  void FreeChunk(const FrameChunk &chunk);
+  void Grow(size_t count);
+  void Shrink(std::unique_lock<std::mutex> &lock, size_t count);
+  bool RetireFrame(std::unique_lock<std::mutex> &lock, Page *page);
+
+  Page *GetFrame(std::unique_lock<std::mutex> &lock, page_id_t page_id,
+                 IOPriority priority);
+  bool PickVictim(Page *&page);
+  bool Unswizzle(Page *page);
+  void WaitForIO(std::unique_lock<std::mutex> &lock, Page *page);
+  void FinishIO(Page *page);
+  void LoadPages(page_id_t page_id, int count,
+                 std::vector<page_id_t> *loaded_ids, bool wait);
+  void FinishPrefetch(const std::vector<Page *> &run);
+  void ReadFrame(page_id_t page_id, char *page_data);
+  void WriteFrame(page_id_t page_id, const char *page_data,
+                  IOPriority priority = IO_PRIORITY_WRITE);
+
+  // the memory owned by the pool for a page
+  inline char *FrameOf(Page *page) { return page->frame_; }
+
+  void pin_page(Page* p){
+    p->pin_count_++;
+    p->last_used_ = ++use_count_;
+  }
+
+  void unpin_page(Page *p) {
+    if (--p->pin_count_ == 0) {
+      replacer_insert(p);
+    }
+  }
+
+  // the replacer, keeping track of whether the page is in it for the unpins
+  // done without latch_
+  void replacer_insert(Page *p) {
+    replacer_->Insert(p);
+    p->in_replacer_ = true;
+  }
+
+  void replacer_erase(Page *p) {
+    replacer_->Erase(p);
+    p->in_replacer_ = false;
+  }
+
+  // the page leaves the pool, call before its page id is reset
+  void replacer_remove(Page *p) {
+    replacer_->Remove(p);
+    p->in_replacer_ = false;
+  }
+};
+} // namespace cmudb
@@ -4,48 +4,164 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool is split into independent instances (see buffer_pool_instance.h),
+ * each with its own latch. Page ids are hashed to an instance by stripes of
+ * BUFFER_POOL_STRIPE pages, so that threads working on different pages rarely
+ * wait for each other while a run of adjacent pages still lands in one
+ * instance and can be read ahead with one I/O.
+ *
+ * An optional background writer keeps some frames of every instance free,
+ * writing back the dirty pages that are about to be evicted, so that a miss
+ * rarely has to write a victim back (or flush the log) itself.
+ *
+ * The pool can be resized while in use, every instance grows or shrinks by its
+ * share.
+ *
+ * The ids of the pages in the pool (the hot set) can be saved, typically at
+ * shutdown, and loaded back at startup with large sequential reads in the
+ * background, so that the pool warms up at disk bandwidth instead of one
+ * random read per miss.
+ *
+ * Optionally, evicted pages are kept compressed in memory as a second tier
+ * (see compressed_cache.h), shared out between the instances.
+ *
+ * A page that is fetched often from a known place, like the children of an
+ * index page, can be fetched through a swizzled reference: the frame where
+ * the page was found last time. As long as the page is still there, it is
+ * pinned without a page table lookup and without the latch of its instance.
+ * Once it is evicted the reference is stale and the page is fetched as usual.
+ * References live in memory only, the page images keep the page ids.
  */
 
 #pragma once
-#include <list>
-#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
-#include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
-#include "logging/log_manager.h"
-#include "page/page.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_instance.h"
 
 namespace cmudb {
+
+#define BUFFER_POOL_STRIPE 8 // adjacent pages that go to the same instance
+#define BACKGROUND_WRITER_INTERVAL 10 // ms between rounds of the writer
+#define PREFETCH_WINDOW 16 // pages a scan keeps in flight ahead of itself
+
 class BufferPoolManager {
 public:
+  // page I/O goes through io_scheduler if not nullptr. The pages are split
+  // evenly between num_instances instances, which evict pages with the
+  // given policy into a compressed cache of compressed_cache_size bytes
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+                    LogManager *log_manager = nullptr,
+                    IOScheduler *io_scheduler = nullptr,
+                    size_t num_instances = BUFFER_POOL_INSTANCES,
+                    ReplacerPolicy policy = LRU_REPLACER,
+                    size_t compressed_cache_size = 0);
 
   ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  // strategy: the ring of a large scan, the page is taken into it if it
+  // has to be loaded
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr);
+  // hint: how hard to try to keep the page in the pool, see page.h
+  Page *FetchPage(page_id_t page_id, PageHint hint);
 
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
+  // fetch through the swizzled reference ref, which is set to the frame of
+  // the page if it had to be looked up. ref starts as nullptr
+  Page *FetchPage(page_id_t page_id, std::atomic<Page *> &ref,
+                  PageHint hint = PAGE_HINT_NORMAL);
+  // unpin by frame, cheaper than by page id for clean pages
+  bool UnpinFrame(Page *page, bool is_dirty);
+  // swizzled references to the children of an index page, by slot. They
+  // belong to the frame, a reference may be stale or be that of another page
+  std::atomic<Page *> *GetChildRefs(Page *page);
+
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  // near_page_id: a page of the same table/index, to keep them in one extent
+  Page *NewPage(page_id_t &page_id, page_id_t near_page_id = INVALID_PAGE_ID,
+                PageHint hint = PAGE_HINT_NORMAL);
 
   bool DeletePage(page_id_t page_id);
 
+  // load [page_id, page_id + count) with large sequential reads, unpinned.
+  // With a strategy, at most half of its ring is read ahead
+  void ReadAhead(page_id_t page_id, int count,
+                 BufferAccessStrategy *strategy = nullptr);
+
+  // start loading [page_id, page_id + count) without waiting for it, the
+  // pages are not pinned. Asynchronous with an I/O scheduler only
+  void PrefetchPages(page_id_t page_id, int count,
+                     BufferAccessStrategy *strategy = nullptr);
+  inline void PrefetchPage(page_id_t page_id) { PrefetchPages(page_id, 1); }
+
+  // readahead of a scan stepping onto next_page_id, window_end is kept by the
+  // scan and starts as INVALID_PAGE_ID
+  void PrefetchWindow(page_id_t next_page_id, page_id_t &window_end,
+                      BufferAccessStrategy *strategy = nullptr);
+
+  // start the background writer, which keeps free_frames frames of the pool
+  // free. It runs every interval
+  void StartBackgroundWriter(
+      size_t free_frames,
+      std::chrono::milliseconds interval =
+          std::chrono::milliseconds(BACKGROUND_WRITER_INTERVAL));
+  void StopBackgroundWriter();
+
+  // number of pages written back by the background writer so far
+  inline size_t GetNumBackgroundWrites() const { return background_writes_; }
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  // pages read from the compressed cache instead of the disk
+  size_t GetNumCacheHits();
+
+  // grow or shrink the pool online, the number of instances stays the same.
+  // Pinned pages are not evicted, so the pool may end up larger than asked.
+  // Return the new size
+  size_t Resize(size_t pool_size);
+  size_t GetPoolSize();
+
+  // write the ids of the pages in the pool into file_name, the most recently
+  // used first. Return false on I/O error
+  bool DumpHotSet(const std::string &file_name);
+  // load the pages of a hot set that fit into the pool, sorted by page id,
+  // with a background thread unless wait is true. Missing file is not an error
+  void PreloadHotSet(const std::string &file_name, bool wait = false);
+
 private:
-  size_t pool_size_; // number of pages in buffer pool
-  Page *pages_;      // array of pages
   DiskManager *disk_manager_;
-  LogManager *log_manager_;
-  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-  Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-  std::list<Page *> *free_list_; // to find a free page for replacement
-  std::mutex latch_;             // to protect shared data structure
-
-  void pin_page(Page* p){
-    p->pin_count_++;
+  std::vector<BufferPoolInstance *> instances_;
+
+  // background writer
+  void BackgroundWriterThread(size_t free_frames,
+                              std::chrono::milliseconds interval);
+  std::thread *writer_thread_;
+  bool writer_on_;
+  std::atomic<size_t> background_writes_;
+  std::mutex writer_latch_;
+  std::condition_variable writer_cv_;
+
+  // hot set preload
+  void PreloadThread(std::vector<page_id_t> page_ids);
+  std::thread *preload_thread_;
+  std::atomic<bool> preload_stop_;
+
+  void LoadPages(page_id_t page_id, int count, BufferAccessStrategy *strategy,
+                 bool wait);
+  void AddToRing(BufferAccessStrategy *strategy, page_id_t page_id);
+
+  inline BufferPoolInstance *InstanceOf(page_id_t page_id) {
+    // INVALID_PAGE_ID has to go somewhere too
+    return instances_[static_cast<uint64_t>(page_id) / BUFFER_POOL_STRIPE %
+                      instances_.size()];
   }
 };
 } // namespace cmudb
@@ -0,0 +1,62 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) replacement over the frames of a buffer
+ * pool. Every frame has a state word with an evictable bit (the page is
+ * unpinned) and a reference bit (the page was used since the hand last went
+ * by). Insert and Erase only update the state word of the frame with one
+ * atomic operation, no lock is taken. Victim sweeps the frames from the hand
+ * on, clearing reference bits, and takes the first evictable frame whose
+ * reference bit is already clear. The frames may come in several chunks, as
+ * the buffer pool grows and shrinks.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+class ClockReplacer : public Replacer<Page *> {
+public:
+  // pages: the frames of the buffer pool, every value is one of them
+  ClockReplacer(Page *pages, size_t num_pages);
+
+  ~ClockReplacer();
+
+  void Insert(Page *const &value);
+
+  bool Victim(Page *&value);
+
+  bool Erase(Page *const &value);
+
+  size_t Size();
+
+  // add or remove a chunk of frames, the removed ones must not be evictable.
+  // Must not run concurrently with the other methods
+  void AddFrames(Page *pages, size_t num_pages);
+  void RemoveFrames(Page *pages);
+
+private:
+  static const uint8_t EVICTABLE = 1;
+  static const uint8_t REFERENCED = 2;
+
+  struct Chunk {
+    Page *pages;
+    size_t num_pages;
+    std::atomic<uint8_t> *state; // state word of every frame
+  };
+
+  std::atomic<uint8_t> &StateOf(Page *page);
+
+  std::vector<Chunk> chunks_;
+  size_t num_pages_;         // in all the chunks
+  std::atomic<size_t> hand_; // next frame to look at, modulo num_pages_
+  std::atomic<size_t> size_; // number of evictable frames
+};
+
+} // namespace cmudb
@@ -0,0 +1,55 @@
+/**
+ * compressed_cache.h
+ *
+ * Second tier of the buffer pool: images of clean pages evicted from the pool,
+ * kept compressed in memory (see disk/lz_codec.h) and looked up on a page
+ * table miss before going to the disk. Table pages are mostly free space or
+ * repetitive, so the same memory holds several times more pages than frames
+ * would. The cache is exclusive: a page taken back into the pool leaves it,
+ * so it never holds an image older than the one in the pool. Pages that are
+ * evicted first are dropped first when the cache is full.
+ */
+
+#pragma once
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class CompressedCache {
+public:
+  // capacity: bytes of compressed images
+  explicit CompressedCache(size_t capacity);
+
+  // keep the image of a page that is the same as on disk. A page that doesn't
+  // compress to half of its size is not worth it and is left out
+  void Put(page_id_t page_id, const char *page_data);
+  // take the page out of the cache into page_data, false if it is not there
+  bool Get(page_id_t page_id, char *page_data);
+  void Erase(page_id_t page_id);
+
+  size_t GetSize();
+  inline size_t GetNumHits() const { return num_hits_; }
+
+private:
+  struct Entry {
+    std::vector<char> image;
+    std::list<page_id_t>::iterator lru; // position in lru_
+  };
+
+  void Remove(std::unordered_map<page_id_t, Entry>::iterator it);
+
+  size_t capacity_;
+  size_t size_; // bytes of the images in the cache
+  std::unordered_map<page_id_t, Entry> entries_;
+  std::list<page_id_t> lru_; // least recently put first
+  std::atomic<size_t> num_hits_;
+  std::mutex latch_; // protect everything above but num_hits_
+};
+
+} // namespace cmudb
@@ -0,0 +1,37 @@
+/**
+ * frame_arena.h
+ *
+ * The memory of the frames of a buffer pool: one anonymous mapping, backed by
+ * explicit huge pages when the system has some reserved, or else marked for
+ * transparent huge pages, so that a large pool takes few TLB entries. The
+ * mapping is page aligned, which is enough for O_DIRECT. Frames hold page
+ * data only, their metadata lives in the Page array of the pool.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace cmudb {
+
+#define HUGE_PAGE_SIZE (2 << 20) // size of a huge page on x86-64
+
+class FrameArena {
+public:
+  FrameArena(size_t num_frames, size_t frame_size);
+  ~FrameArena();
+
+  inline char *GetFrame(size_t i) { return base_ + i * frame_size_; }
+  inline char *GetBase() { return base_; }
+
+  // the arena is backed by explicit (hugetlbfs) huge pages
+  inline bool UsesHugePages() const { return huge_pages_; }
+
+private:
+  char *base_;
+  size_t size_;
+  size_t frame_size_;
+  bool huge_pages_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,90 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement. Every page remembers the times of its
+ * last K references (a reference is the page being unpinned, time is counted
+ * in references). The victim is the page whose K-th most recent reference is
+ * the oldest; pages referenced less than K times go first, least recently
+ * used first. A page that is read once by a scan therefore leaves before the
+ * pages that are used over and over, however recent the scan is.
+ *
+ * A reference within the correlated reference period of the previous one to
+ * the same page (e.g. the next tuple of the page) only updates the time of
+ * the previous one, and a page referenced within that period is not evicted
+ * unless every page is. The history of evicted pages is retained for a while,
+ * so a page that comes back soon is not taken for a page seen once.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+#define LRU_K 2                   // references remembered per page
+#define LRU_K_CORRELATED_PERIOD 8 // in references
+
+// what the history of a value is kept by: pages by page id, since the frame
+// is reused for other pages
+template <typename T> inline int64_t HistoryKey(const T &value) {
+  return value;
+}
+template <> inline int64_t HistoryKey(Page *const &value) {
+  return value->GetPageId();
+}
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+public:
+  // history_size: how many evicted pages have their history retained
+  LRUKReplacer(size_t k = LRU_K,
+               size_t correlated_period = LRU_K_CORRELATED_PERIOD,
+               size_t history_size = 1024);
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  // like Erase(), the history of the value is retained as if it was evicted
+  bool Remove(const T &value);
+
+  size_t Size();
+
+  // values whose history is kept, evictable, pinned or retained
+  size_t GetHistorySize();
+
+private:
+  struct History {
+    std::deque<size_t> refs; // most recent first, at most k_
+    bool retained = false;   // the page was evicted
+    std::list<int64_t>::iterator retained_pos;
+  };
+  // eviction order: (has k_ references, K-th or else last reference, value)
+  typedef std::tuple<bool, size_t, T> Entry;
+
+  size_t k_;
+  size_t correlated_period_;
+  size_t history_size_;
+  size_t now_; // references so far
+  std::unordered_map<int64_t, History> history_;
+  std::list<int64_t> retained_; // keys of the evicted pages, oldest first
+  std::set<Entry> order_;       // the values that can be evicted
+  std::unordered_map<T, typename std::set<Entry>::iterator> map_;
+  std::mutex latch_;
+
+  void Retain(int64_t key);
+};
+
+} // namespace cmudb
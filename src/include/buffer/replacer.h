@@ -9,6 +9,13 @@
 
 namespace cmudb {
 
+// how the buffer pool picks the page to evict
+enum ReplacerPolicy {
+  LRU_REPLACER = 0, // least recently unpinned page, see lru_replacer.h
+  CLOCK_REPLACER,   // second chance, see clock_replacer.h
+  LRU_K_REPLACER,   // oldest K-th most recent reference, see lru_k_replacer.h
+};
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -16,6 +23,8 @@ public:
   virtual void Insert(const T &value) = 0;
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
+  // value leaves the pool without being a victim, rather than being pinned
+  virtual bool Remove(const T &value) { return Erase(value); }
   virtual size_t Size() = 0;
 };
 
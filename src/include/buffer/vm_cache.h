@@ -0,0 +1,85 @@
+/**
+ * vm_cache.h
+ *
+ * Buffer manager in the style of vmcache (Leis et al., SIGMOD 2023), as an
+ * alternative to BufferPoolManager for working sets that mostly fit in
+ * memory. Virtual memory is reserved for every page the database can have:
+ * page i lives at base + i * stride, so there is no page table. Every page id
+ * has a state word instead, which holds the metadata slot of the page while
+ * it is resident, or LOCKED while it is being loaded or evicted:
+ *
+ *   0: evicted            LOCKED: being loaded
+ *   slot + 1: resident    (slot + 1) | LOCKED: being evicted
+ *
+ * A hit takes no latch, it reads the state word and pins the page. Only
+ * pool_size pages take physical memory at a time, an evicted page gives its
+ * memory back with madvise(MADV_DONTNEED). Victims are picked by CLOCK over
+ * the slots.
+ *
+ * The stride is the page size, but at least an OS page, as memory is given
+ * back to the kernel by OS page: pages smaller than that take a whole OS page
+ * each.
+ */
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "disk/disk_manager.h"
+#include "logging/log_manager.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+#define VM_CACHE_MAX_PAGES (1 << 22) // default size of the reservation, pages
+
+class VMCache {
+public:
+  // max_pages: page ids from there on can't be loaded
+  VMCache(size_t pool_size, DiskManager *disk_manager,
+          LogManager *log_manager = nullptr,
+          size_t max_pages = VM_CACHE_MAX_PAGES);
+
+  ~VMCache();
+
+  Page *FetchPage(page_id_t page_id);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(page_id_t page_id);
+
+  // near_page_id: a page of the same table/index, to keep them in one extent
+  Page *NewPage(page_id_t &page_id, page_id_t near_page_id = INVALID_PAGE_ID);
+
+  bool DeletePage(page_id_t page_id);
+
+  inline size_t GetMaxPages() const { return max_pages_; }
+
+private:
+  static const uint64_t LOCKED = 1ull << 63;
+  static const size_t NO_SLOT = static_cast<size_t>(-1);
+
+  Page *Load(page_id_t page_id, bool read);
+  Page *PinResident(page_id_t page_id);
+  size_t GetSlot();
+  bool Evict(size_t slot, bool write_back);
+  void FreeSlot(size_t slot);
+
+  size_t pool_size_;
+  size_t max_pages_;
+  size_t stride_; // bytes between two pages
+  DiskManager *disk_manager_;
+  LogManager *log_manager_;
+  char *frames_;                   // virtual memory of all the pages
+  std::atomic<uint64_t> *states_;  // state word of every page id
+  Page *slots_;                    // metadata of the resident pages
+  std::atomic<page_id_t> *owners_; // page of every slot, or INVALID_PAGE_ID
+  std::atomic<bool> *dirty_;       // by slot
+  std::atomic<bool> *referenced_;  // by slot, for CLOCK
+  std::atomic<size_t> hand_;       // next slot CLOCK looks at
+  std::vector<size_t> free_slots_;
+  std::mutex free_latch_; // protect free_slots_
+};
+
+} // namespace cmudb
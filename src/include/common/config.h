@@ -18,18 +18,26 @@ extern std::chrono::duration<long long int> WAIT_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+// size of a data page in byte, set by the disk manager from the header of the
+// database file it opens (or creates)
+extern int PAGE_SIZE;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
+#define DEFAULT_PAGE_SIZE 512 // page size of a new database, if not chosen
+#define MIN_PAGE_SIZE 512     // page sizes are powers of two in this range
+#define MAX_PAGE_SIZE 32768
 #define LOG_BUFFER_SIZE                                                            \
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define BUFFER_POOL_INSTANCES 1       // partitions of the buffer pool
+#define CACHE_LINE_SIZE 64             // to keep hot data apart
 
-typedef int32_t page_id_t; // page id type
+typedef int64_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
-typedef int32_t lsn_t;     // log sequence number type
+typedef int64_t lsn_t;     // log sequence number type
 
 } // namespace cmudb
\ No newline at end of file
@@ -11,15 +11,29 @@
 
 namespace cmudb {
 
+// the slot number takes the low bits of a rid packed into 64 bits, a page
+// holds at most MAX_PAGE_SIZE / 8 tuples
+#define RID_SLOT_BITS 16
+#define RID_INVALID_SLOT 0xFFFF
+
 class RID {
 public:
   RID() : page_id_(INVALID_PAGE_ID), slot_num_(-1){}; // invalid rid
   RID(page_id_t page_id, int slot_num)
       : page_id_(page_id), slot_num_(slot_num){};
 
-  RID(int64_t rid) : page_id_(rid >> 32), slot_num_(rid){};
-
-  inline int64_t Get() const { return ((int64_t)page_id_) << 32 | slot_num_; }
+  // all the slot bits set is the slot of the invalid rid
+  RID(int64_t rid)
+      : page_id_(rid >> RID_SLOT_BITS),
+        slot_num_(static_cast<uint16_t>(rid) == RID_INVALID_SLOT
+                      ? -1
+                      : static_cast<uint16_t>(rid)){};
+
+  inline int64_t Get() const {
+    return static_cast<int64_t>(static_cast<uint64_t>(page_id_)
+                                    << RID_SLOT_BITS |
+                                static_cast<uint16_t>(slot_num_));
+  }
 
   inline page_id_t GetPageId() const { return page_id_; }
 
@@ -0,0 +1,80 @@
+/**
+ * compressed_disk_manager.h
+ *
+ * Disk manager that keeps pages compressed on disk with LZCodec. Allocation
+ * is still tracked by the bitmap pages of the database file, but page images
+ * live in a data file (<db>.zdb) made of COMPRESSION_SECTOR_SIZE sectors: a
+ * page occupies a slot of consecutive sectors just large enough for its
+ * compressed image. The page mapping table (<db>.map) has one entry per page
+ * id telling where its slot is. Pages that don't compress are stored as is.
+ *
+ * A page is never rewritten in place: every write goes to a free slot (best
+ * fit) or to the end of the data file, and the old slot is freed once the new
+ * mapping entry is written, so that a crash in between leaves the old image
+ * and its entry intact.
+ *
+ * All the page images share one data file, so there is only tablespace 0.
+ * Disk space is reserved ahead in the data file, not in the database file
+ * that only holds the bitmaps. DISK_DIRECT_IO only applies to the database
+ * file: images and mapping entries are written in pieces smaller than what
+ * O_DIRECT allows, through the page cache.
+ */
+
+#pragma once
+#include <map>
+#include <vector>
+
+#include "disk/disk_manager.h"
+
+namespace cmudb {
+
+#define COMPRESSION_SECTOR_SIZE 64 // allocation unit of the data file
+
+class CompressedDiskManager : public DiskManager {
+public:
+  CompressedDiskManager(const std::string &db_file, int flags = 0);
+  ~CompressedDiskManager();
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+  void ReadPage(page_id_t page_id, char *page_data) override;
+  void WritePages(page_id_t page_id, int count,
+                  const char *const *pages) override;
+  void ReadPages(page_id_t page_id, int count, char **pages) override;
+
+  int AddTablespace(const std::string &file_name) override;
+  void DeallocatePage(page_id_t page_id) override;
+
+  // bytes taken by the page images currently stored
+  size_t GetStoredBytes();
+
+protected:
+  // the database file has no page images
+  void Preallocate(DataFile *, off_t) override {}
+
+private:
+  // entry of the page mapping table, sectors is 0 if the page has no image
+  struct MapEntry {
+    uint32_t sector;  // first sector of the slot
+    uint16_t size;    // bytes of the image, PAGE_SIZE if not compressed
+    uint16_t sectors; // size of the slot
+  };
+
+  void LoadMapping();
+  void WriteEntry(page_id_t page_id, const MapEntry &entry);
+  uint32_t TakeSlot(uint16_t sectors);
+  void ReleaseSlot(uint32_t sector, uint16_t sectors);
+
+  int map_fd_;  // page mapping table
+  int data_fd_; // page images
+  std::vector<MapEntry> map_;
+  // free slots, by size
+  std::multimap<uint16_t, uint32_t> free_slots_;
+  // first sector after the last slot
+  uint32_t end_sector_;
+  // the data file has space reserved up to this sector
+  uint32_t reserved_sector_;
+  // protect map_, free_slots_ and end_sector_
+  std::mutex map_latch_;
+};
+
+} // namespace cmudb
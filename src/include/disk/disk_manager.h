@@ -5,46 +5,218 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Pages are stored in tablespaces, one data file each, so that objects can be
+ * placed on different devices. Tablespace 0 is the database file itself, the
+ * others are recorded in its header and opened with it. A page id carries its
+ * tablespace in the bits above TABLESPACE_SHIFT and its page within the data
+ * file below. Data files have their own bitmap pages and allocation latch, and
+ * page I/O is positional, so I/O to different files proceeds in parallel.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace cmudb {
 
+// flags to open the database file with, can be or-ed together
+enum DiskManagerFlags {
+  DISK_DIRECT_IO = 0x1, // bypass the OS page cache with O_DIRECT
+  DISK_READ_ONLY = 0x2, // open an existing file read-only and mmap it
+};
+
+// access pattern hints, see DiskManager::Advise()
+enum AccessPattern {
+  ACCESS_NORMAL = 0,
+  ACCESS_SEQUENTIAL,
+  ACCESS_RANDOM,
+  ACCESS_WILLNEED, // the pages will be accessed soon, read them ahead
+};
+
+#define DIRECT_IO_ALIGNMENT 4096 // buffer alignment for O_DIRECT page I/O
+#define PREALLOCATE_PAGES 64     // pages reserved at a time when file grows
+#define EXTENT_SIZE 64           // contiguous pages kept together for an object
+// number of pages whose allocation state is tracked by one bitmap page
+#define BITMAP_PAGE_BITS (PAGE_SIZE * 8)
+
+// page ids carry the tablespace they live in above this bit. Page ids stay
+// below 2^47, so that a RID still packs into 64 bits
+#define TABLESPACE_SHIFT 40
+#define MAX_TABLESPACES (1 << (47 - TABLESPACE_SHIFT))
+#define LOCAL_PAGE_MASK ((static_cast<page_id_t>(1) << TABLESPACE_SHIFT) - 1)
+
+static inline int TablespaceOf(page_id_t page_id) {
+  return static_cast<int>(page_id >> TABLESPACE_SHIFT);
+}
+// the page within the data file of its tablespace
+static inline page_id_t LocalPageId(page_id_t page_id) {
+  return page_id & LOCAL_PAGE_MASK;
+}
+static inline page_id_t MakePageId(int tablespace, page_id_t local_page_id) {
+  return (static_cast<page_id_t>(tablespace) << TABLESPACE_SHIFT) |
+         local_page_id;
+}
+// allocation hint for the first page of an object: the lowest free page of the
+// tablespace. TablespaceHint(0) is INVALID_PAGE_ID
+static inline page_id_t TablespaceHint(int tablespace) {
+  return -1 - tablespace;
+}
+
+// the first page sized slot of a data file. The one of the database file is
+// followed by the nul terminated names of the other tablespaces' data files
+struct FileHeader {
+  char magic[7]; // DB_FILE_MAGIC
+  uint8_t version; // format of the pages, 0 for files of version 1
+  uint32_t page_size;
+  uint32_t num_tablespaces; // not counting tablespace 0
+};
+
+#define DB_FILE_MAGIC "cmudb\0" // identifies a database file
+// version 1 had 32-bit page ids and LSNs in the pages, version 2 has 64-bit
+// ones. Files of another version than this one are refused
+#define DB_FORMAT_VERSION 2
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
-  ~DiskManager();
+  // page_size is used when the database file is created (DEFAULT_PAGE_SIZE if
+  // 0), an existing file keeps the page size stored in its header. All open
+  // databases of the process share one page size, a database with another
+  // page size can't be opened until the others are closed
+  DiskManager(const std::string &db_file, int flags = 0, int page_size = 0);
+  virtual ~DiskManager();
+
+  virtual void WritePage(page_id_t page_id, const char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+
+  // asynchronous page I/O, requests are queued until SubmitBatch() is called.
+  // The default implementation performs the I/O synchronously.
+  virtual std::future<void> WritePageAsync(page_id_t page_id,
+                                           const char *page_data);
+  virtual std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+  virtual void SubmitBatch() {}
 
-  void WritePage(page_id_t page_id, const char *page_data);
-  void ReadPage(page_id_t page_id, char *page_data);
+  // vectored I/O of the contiguous pages [page_id, page_id + count)
+  virtual void WritePages(page_id_t page_id, int count,
+                          const char *const *pages);
+  virtual void ReadPages(page_id_t page_id, int count, char **pages);
 
   void WriteLog(char *log_data, int size);
-  bool ReadLog(char *log_data, int size, int offset);
+  bool ReadLog(char *log_data, int size, off_t offset);
 
-  page_id_t AllocatePage();
-  void DeallocatePage(page_id_t page_id);
+  // add a data file (created if it doesn't exist) as a new tablespace and
+  // return its id, or -1 on error
+  virtual int AddTablespace(const std::string &file_name);
+  int GetNumTablespaces() const;
 
+  // allocate a page in the extent of near_page_id if it has room, otherwise
+  // start a new extent of its tablespace. Without a hint, the lowest free page
+  // is returned (see TablespaceHint)
+  page_id_t AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID);
+  virtual void DeallocatePage(page_id_t page_id);
+  bool IsAllocated(page_id_t page_id);
+
+  // zero-copy access to the pages of a read-only database
+  const char *GetMappedPage(page_id_t page_id) const;
+  void Advise(AccessPattern pattern, page_id_t page_id = INVALID_PAGE_ID,
+              int count = 0);
+
+  // format version of the database file, see DB_FORMAT_VERSION. The file
+  // is not opened unless it is DB_FORMAT_VERSION
+  inline int GetFormatVersion() const { return format_version_; }
   int GetNumFlushes() const;
   bool GetFlushState() const;
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
+  inline bool IsDirectIO() const { return flags_ & DISK_DIRECT_IO; }
+  inline bool IsReadOnly() const { return flags_ & DISK_READ_ONLY; }
+
+protected:
+  // a data file, it holds the pages of one tablespace
+  struct DataFile {
+    std::string name;
+    // page I/O is positional (pread/pwrite) so the file descriptor can be
+    // shared among threads without a seek pointer
+    int fd = -1;
+    // file size, maintained on writes instead of calling stat() on reads
+    std::atomic<off_t> size{0};
+    // whole file mapped read-only (DISK_READ_ONLY), or nullptr
+    char *map = nullptr;
+    size_t map_size = 0;
+    // free-page bitmaps, one page per group, bit set means allocated
+    std::vector<char *> bitmaps;
+    // there is no free page below this local page id
+    page_id_t next_page_id = 0;
+    // the file has space reserved up to here
+    off_t preallocated_end = 0;
+    // protect bitmaps, next_page_id and preallocated_end
+    std::mutex alloc_latch;
+  };
+
+  // offset of a page in the data file of its tablespace. The file starts with
+  // the FileHeader, then the bitmap page of every group of BITMAP_PAGE_BITS
+  // pages is stored right before the group, so page ids stay dense
+  static inline off_t PageOffset(page_id_t page_id) {
+    page_id = LocalPageId(page_id);
+    return (static_cast<off_t>(page_id) + page_id / BITMAP_PAGE_BITS + 2) *
+           PAGE_SIZE;
+  }
+  static inline off_t BitmapOffset(size_t group) {
+    return (static_cast<off_t>(group) * (BITMAP_PAGE_BITS + 1) + 1) *
+           PAGE_SIZE;
+  }
+  // true if page_data can't be handed to the file descriptor as is
+  inline bool NeedsBounceBuffer(const char *page_data) const {
+    return IsDirectIO() &&
+           reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0;
+  }
+  // data file of a tablespace, or nullptr if there is no such tablespace
+  inline DataFile *GetFile(int tablespace) const {
+    if (tablespace < 0 || tablespace >= num_tablespaces_)
+      return nullptr;
+    return files_[tablespace];
+  }
+  inline DataFile *FileOf(page_id_t page_id) const {
+    return GetFile(TablespaceOf(page_id));
+  }
+  void UpdateFileSize(DataFile *file, off_t end);
+  // reserve disk space for the pages of the file up to "end" bytes
+  virtual void Preallocate(DataFile *file, off_t end);
 
 private:
-  int GetFileSize(const std::string &name);
+  off_t GetFileSize(const std::string &name);
+  bool OpenDataFile(DataFile *file, int page_size,
+                    std::vector<std::string> *tablespaces);
+  void OpenMapping(DataFile *file);
+  bool ReadHeader(DataFile *file, std::vector<std::string> *tablespaces);
+  bool ClaimPageSize(int page_size);
+  void WriteHeader(DataFile *file, int page_size);
+  size_t HeaderSize(int num_tablespaces) const;
+  void AdviseFile(DataFile *file, AccessPattern pattern, off_t offset,
+                  off_t len);
+  void LoadBitmaps(DataFile *file);
+  void WriteBitmap(DataFile *file, size_t group);
+  bool FindFreePage(DataFile *file, size_t group, int from, int to, int &bit);
+  page_id_t FindEmptyExtent(DataFile *file);
+  int RunLength(page_id_t page_id, int count);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
-  std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  int flags_;
+  int format_version_;
+  // data files by tablespace id, the array never moves so readers don't latch
+  DataFile *files_[MAX_TABLESPACES];
+  std::atomic<int> num_tablespaces_;
+  // whether this database holds the global PAGE_SIZE
+  bool owns_page_size_;
+  // serialize AddTablespace()
+  std::mutex tablespace_latch_;
   int num_flushes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
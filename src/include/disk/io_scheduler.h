@@ -0,0 +1,118 @@
+/**
+ * io_scheduler.h
+ *
+ * I/O scheduling layer between the buffer pool / log manager and the disk
+ * manager. Requests are queued by priority class and dispatched by a small
+ * pool of worker threads, always from the most urgent class that has a
+ * request waiting and is below its queue depth limit:
+ *
+ *   log flush > foreground read > background write > prefetch
+ *
+ * so that a burst of dirty evictions can't hold up point reads. Pending page
+ * writes are kept sorted by page id: a later write of the same page replaces
+ * the queued image, and adjacent pages are written with one vectored I/O, in
+ * ascending page id order (one way elevator). Reads of a page with a queued
+ * or in flight write are served from the image being written.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "disk/disk_manager.h"
+
+namespace cmudb {
+
+// priority classes, the most urgent first
+enum IOPriority {
+  IO_PRIORITY_LOG = 0,
+  IO_PRIORITY_READ,     // a query waits for the page
+  IO_PRIORITY_WRITE,    // write back of dirty pages
+  IO_PRIORITY_PREFETCH, // pages that may be needed later
+  NUM_IO_PRIORITIES
+};
+
+#define IO_SCHEDULER_WORKERS 4 // default number of worker threads
+#define MAX_COALESCED_PAGES 64 // most pages written by one vectored I/O
+
+class IOScheduler {
+public:
+  explicit IOScheduler(DiskManager *disk_manager,
+                       int num_workers = IO_SCHEDULER_WORKERS);
+  ~IOScheduler();
+
+  // the page buffers must stay valid until the returned future is satisfied.
+  // on_done is called by the worker once the pages are read, right before
+  // the future is satisfied
+  std::future<void> ReadPage(page_id_t page_id, char *page_data,
+                             IOPriority priority = IO_PRIORITY_READ);
+  std::future<void> ReadPages(page_id_t page_id, int count, char **pages,
+                              IOPriority priority = IO_PRIORITY_PREFETCH,
+                              std::function<void()> on_done = nullptr);
+  std::future<void> WritePage(page_id_t page_id, const char *page_data,
+                              IOPriority priority = IO_PRIORITY_WRITE);
+  // log writes are appended in the order they are scheduled
+  std::future<void> WriteLog(char *log_data, int size);
+
+  // how many requests of a class may be in the disk at the same time. The
+  // log is always written by one worker at a time
+  void SetQueueDepth(IOPriority priority, int depth);
+  int GetQueueDepth(IOPriority priority);
+
+  // number of vectored writes issued so far, each covers adjacent pages
+  inline size_t GetNumWrites() const { return num_writes_; }
+
+  inline DiskManager *GetDiskManager() { return disk_manager_; }
+
+private:
+  // a read or log write waiting in the queue of its class
+  struct Request {
+    page_id_t page_id; // first page, or INVALID_PAGE_ID for the log
+    int count;         // pages, or bytes for the log
+    char **pages;      // nullptr for the log
+    char *data;        // single page or log data
+    std::function<void()> on_done;
+    std::promise<void> done;
+  };
+  // a write of a page, all the writers are notified once it's done
+  struct PendingWrite {
+    const char *data;
+    int priority;
+    bool in_flight;
+    std::vector<std::promise<void>> done;
+  };
+
+  void WorkerThread();
+  int PickClass();
+  void Dispatch(std::unique_lock<std::mutex> &lock, Request *req);
+  void DispatchWrites(std::unique_lock<std::mutex> &lock, int priority);
+  bool CopyPendingWrite(page_id_t page_id, char *page_data);
+
+  DiskManager *disk_manager_;
+  std::vector<std::thread> workers_;
+  // reads and log writes, by class
+  std::deque<Request *> queues_[NUM_IO_PRIORITIES];
+  // pages to write, sorted by page id, until the write is done
+  std::map<page_id_t, PendingWrite> writes_;
+  // writes not dispatched yet, by class
+  int queued_writes_[NUM_IO_PRIORITIES];
+  // writes are dispatched from here on upwards, then wrap around
+  page_id_t write_cursor_;
+  int queue_depth_[NUM_IO_PRIORITIES];
+  int in_flight_[NUM_IO_PRIORITIES];
+  std::atomic<size_t> num_writes_;
+  bool shutdown_;
+  // protect everything above
+  std::mutex latch_;
+  std::condition_variable work_cv_;
+  // notified when a write is done
+  std::condition_variable write_cv_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,31 @@
+/**
+ * lz_codec.h
+ *
+ * A small LZ77 family codec (LZ4 like block format) for page images. The
+ * compressed block is a sequence of
+ *  -----------------------------------------------------------------------
+ * | token (1) | literal length (0+) | literals | offset (2) | match length |
+ *  -----------------------------------------------------------------------
+ * the high 4 bits of the token hold the literal length and the low 4 bits the
+ * match length minus LZ_MIN_MATCH, 15 means that more length bytes follow
+ * (each adds up to 255). The last sequence only has literals.
+ */
+
+#pragma once
+
+namespace cmudb {
+
+#define LZ_MIN_MATCH 4       // shortest match worth encoding
+#define LZ_MAX_OFFSET 0xFFFF // farthest match that can be referenced
+#define LZ_HASH_BITS 12      // log2 of the number of hash table entries
+
+class LZCodec {
+public:
+  // return the compressed size, or 0 if it doesn't fit into capacity bytes
+  static int Compress(const char *src, int size, char *dst, int capacity);
+  // return the decompressed size, or -1 if the block is corrupted or doesn't
+  // fit into capacity bytes
+  static int Decompress(const char *src, int size, char *dst, int capacity);
+};
+
+} // namespace cmudb
@@ -0,0 +1,90 @@
+/**
+ * uring_disk_manager.h
+ *
+ * Disk manager that performs page I/O through a Linux io_uring instance, so
+ * that many reads and writes can be in flight at the same time. Requests made
+ * through ReadPageAsync/WritePageAsync are placed in the submission queue and
+ * handed to the kernel in one system call by SubmitBatch(). A dedicated thread
+ * reaps completions and fulfills the returned futures.
+ *
+ * Log I/O is still served by the base DiskManager. If the kernel does not
+ * support io_uring, page I/O falls back to synchronous pread/pwrite.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "disk/disk_manager.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace cmudb {
+
+#define URING_QUEUE_DEPTH 64 // number of submission queue entries
+
+class UringDiskManager : public DiskManager {
+public:
+  UringDiskManager(const std::string &db_file, int flags = 0,
+                   unsigned queue_depth = URING_QUEUE_DEPTH);
+  ~UringDiskManager();
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  std::future<void> WritePageAsync(page_id_t page_id,
+                                   const char *page_data) override;
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) override;
+  void SubmitBatch() override;
+
+  // false if the kernel refused to set up a ring (synchronous fallback)
+  inline bool IsAsync() const { return ring_fd_ >= 0; }
+
+private:
+  // an in-flight request, its address is the user_data of the sqe
+  struct Request {
+    std::promise<void> done;
+    char *read_buf; // nullptr for writes
+    char *bounce;   // aligned copy of the page for O_DIRECT, or nullptr
+    DataFile *file; // data file of the page
+    off_t end;      // file offset right after the page
+  };
+
+  bool SetupRing(unsigned queue_depth);
+  std::future<void> Enqueue(int opcode, page_id_t page_id, char *buf);
+  io_uring_sqe *GetSqe();
+  void SubmitLocked();
+  void CompletionThread();
+  void Complete(Request *req, int res);
+
+  int ring_fd_;
+  // submission ring
+  void *sq_ring_;
+  size_t sq_ring_size_;
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  io_uring_sqe *sqes_;
+  size_t sqes_size_;
+  unsigned sq_entries_;
+  // completion ring
+  void *cq_ring_;
+  size_t cq_ring_size_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  io_uring_cqe *cqes_;
+  // sqes queued locally but not yet submitted to the kernel
+  unsigned to_submit_;
+  // number of submitted requests whose completion has not been reaped
+  unsigned in_flight_;
+  // protect the submission side of the ring
+  std::mutex sq_latch_;
+  std::condition_variable cq_space_;
+  std::thread *completion_thread_;
+};
+
+} // namespace cmudb
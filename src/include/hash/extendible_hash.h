@@ -5,6 +5,12 @@
  * Functionality: The buffer pool manager must maintain a page table to be able
  * to quickly map a PageId to its corresponding memory location; or alternately
  * report that the PageId does not match any currently-buffered page.
+ *
+ * Concurrency: lookups and modifications that stay within a bucket share the
+ * directory latch and take the latch of their bucket only. Splits, merges and
+ * resizes of the directory hold the directory latch exclusively. A bucket that
+ * is emptied by a removal is merged with its split image, and the directory
+ * is halved once no bucket needs all of its bits.
  */
 
 #pragma once
@@ -16,6 +22,7 @@
 #include <memory>
 #include <mutex>
 
+#include "common/rwmutex.h"
 #include "hash/hash_table.h"
 
 namespace cmudb {
@@ -26,6 +33,8 @@ class ExtendibleHash : public HashTable<K, V> {
   // constructor
   ExtendibleHash(size_t size);
 
+  ~ExtendibleHash();
+
   // helper function to generate hash addressing
   size_t HashKey(const K &key);
 
@@ -49,17 +58,23 @@ class ExtendibleHash : public HashTable<K, V> {
    public:
     int local_depth_;
     std::map<K, V> map_;
+    std::mutex latch_; // protect map_, local_depth_ is covered by dir_latch_
 
     Bucket(int depth) : local_depth_(depth) {}
   };
 
   int GetBucketIndex(size_t hash_value) const;
-  
-  std::shared_ptr<Bucket> GetBucket(const K &key);
 
-  std::vector<std::shared_ptr<Bucket>> bucket_directory_;
+  Bucket *GetBucket(const K &key);
+
+  void Merge(const K &key);
+
+  // every bucket is shared by the 2^(global - local depth) slots of its
+  // prefix
+  std::vector<Bucket *> bucket_directory_;
   int global_depth_;
   const size_t size_limit_;
-  std::mutex latch_;
+  // shared by the operations within a bucket, exclusive for the directory
+  mutable RWMutex dir_latch_;
 };
 } // namespace cmudb
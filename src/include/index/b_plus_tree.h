@@ -30,7 +30,8 @@ class BPlusTree {
   explicit BPlusTree(const std::string &name,
                      BufferPoolManager *buffer_pool_manager,
                      const KeyComparator &comparator,
-                     page_id_t root_page_id = INVALID_PAGE_ID);
+                     page_id_t root_page_id = INVALID_PAGE_ID,
+                     int tablespace = 0);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -47,8 +48,10 @@ class BPlusTree {
                 Transaction *transaction = nullptr);
 
   // index iterator
-  INDEXITERATOR_TYPE Begin();
-  INDEXITERATOR_TYPE Begin(const KeyType &key);
+  // strategy: a ring for the leaf pages of a large range scan
+  INDEXITERATOR_TYPE Begin(BufferAccessStrategy *strategy = nullptr);
+  INDEXITERATOR_TYPE Begin(const KeyType &key,
+                           BufferAccessStrategy *strategy = nullptr);
 
   // Print this B+ tree to stdout using a simple command-line
   std::string ToString(bool verbose = false);
@@ -102,6 +105,17 @@ class BPlusTree {
 
   std::atomic<page_id_t> root_page_id_;
 
+  // levels above the leaves at the last descent, to tell the buffer pool
+  // which pages are inner ones before they are read
+  std::atomic<int> leaf_depth_;
+
+  // swizzled reference to the root, the children of the inner pages have
+  // theirs next to the pages, see BufferPoolManager::GetChildRefs()
+  std::atomic<Page *> root_ref_;
+
+  // the nodes are allocated in this tablespace
+  int tablespace_;
+
   BufferPoolManager *buffer_pool_manager_;
 
   KeyComparator comparator_;
@@ -14,13 +14,17 @@ INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
 
-  IndexIterator(page_id_t page_id, int idx, BufferPoolManager &buff);
+  // strategy: leaf pages are read through this ring if not nullptr, it must
+  // outlive the iterator
+  IndexIterator(page_id_t page_id, int idx, BufferPoolManager &buff,
+                BufferAccessStrategy *strategy = nullptr);
 
   ~IndexIterator();
 
   IndexIterator(const IndexIterator &from) : IndexIterator(from.leaf_page_->GetPageId(),
                                                            from.pos_,
-                                                           from.buffer_pool_) {
+                                                           from.buffer_pool_,
+                                                           from.strategy_) {
   }
   
   IndexIterator &operator=(const IndexIterator &) = delete;
@@ -42,8 +46,10 @@ class IndexIterator {
         end_ = true;
       } else {
         pos_ = 0;
+        // keep the leaves that follow in flight
+        buffer_pool_.PrefetchWindow(next, prefetched_end_, strategy_);
         buffer_pool_.UnpinPage(leaf_page_->GetPageId(), false);
-        Page *page = buffer_pool_.FetchPage(next);
+        Page *page = buffer_pool_.FetchPage(next, strategy_);
         leaf_page_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
       }
     }
@@ -55,11 +61,13 @@ class IndexIterator {
   B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_page_;
   int pos_;
   BufferPoolManager &buffer_pool_;
+  BufferAccessStrategy *strategy_;
+  page_id_t prefetched_end_; // see BufferPoolManager::PrefetchWindow
   bool end_;
 
   B_PLUS_TREE_LEAF_PAGE_TYPE *GetLeafPage(page_id_t page_id) {
     if (page_id == INVALID_PAGE_ID) { return nullptr; }
-    return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(buffer_pool_.FetchPage(page_id)->GetData());
+    return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(buffer_pool_.FetchPage(page_id, strategy_)->GetData());
   }
 };
 
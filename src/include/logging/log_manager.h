@@ -12,17 +12,20 @@
 #include <mutex>
 
 #include "disk/disk_manager.h"
+#include "disk/io_scheduler.h"
 #include "logging/log_record.h"
 
 namespace cmudb {
 
 class LogManager {
  public:
-  LogManager(DiskManager *disk_manager)
+  // log writes go through io_scheduler if not nullptr
+  LogManager(DiskManager *disk_manager, IOScheduler *io_scheduler = nullptr)
       : next_lsn_(0), persistent_lsn_(INVALID_LSN),
-        disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+        disk_manager_(disk_manager), io_scheduler_(io_scheduler),
+        log_buffer_capacity_(LOG_BUFFER_SIZE) {
+    log_buffer_ = new char[log_buffer_capacity_];
+    flush_buffer_ = new char[log_buffer_capacity_];
     flush_thread_on = false;
   }
 
@@ -66,6 +69,7 @@ class LogManager {
   std::condition_variable cv_;
   // disk manager
   DiskManager *disk_manager_;
+  IOScheduler *io_scheduler_;
 
   //========new member==========
   std::atomic<bool> flush_thread_on;
@@ -73,6 +77,8 @@ class LogManager {
   std::mutex append_latch_;
   int flush_buffer_size_{0};
   int log_buffer_size_{0};
+  // LOG_BUFFER_SIZE for the page size at construction
+  const int log_buffer_capacity_;
 };
 
 } // namespace cmudb
@@ -2,9 +2,9 @@
  * log_record.h
  * For every write opeartion on table page, you should write ahead a
  * corresponding log record.
- * For EACH log record, HEADER is like (5 fields in common, 20 bytes in totoal)
+ * For EACH log record, HEADER is like (5 fields in common, 28 bytes in totoal)
  *-------------------------------------------------------------
- * | size | LSN | transID | prevLSN | LogType |
+ * | size (4) | transID (4) | LSN (8) | prevLSN (8) | LogType (4) |
  *-------------------------------------------------------------
  * For insert type log record
  *-------------------------------------------------------------
@@ -52,18 +52,18 @@ class LogRecord {
 
 public:
   LogRecord()
-      : size_(0), lsn_(INVALID_LSN), txn_id_(INVALID_TXN_ID),
+      : size_(0), txn_id_(INVALID_TXN_ID), lsn_(INVALID_LSN),
         prev_lsn_(INVALID_LSN), log_record_type_(LogRecordType::INVALID) {}
 
   // constructor for Transaction type(BEGIN/COMMIT/ABORT)
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type)
-      : size_(HEADER_SIZE), lsn_(INVALID_LSN), txn_id_(txn_id),
+      : size_(HEADER_SIZE), txn_id_(txn_id), lsn_(INVALID_LSN),
         prev_lsn_(prev_lsn), log_record_type_(log_record_type) {}
 
   // constructor for INSERT/DELETE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type,
             const RID &rid, const Tuple &tuple)
-      : lsn_(INVALID_LSN), txn_id_(txn_id), prev_lsn_(prev_lsn),
+      : txn_id_(txn_id), lsn_(INVALID_LSN), prev_lsn_(prev_lsn),
         log_record_type_(log_record_type) {
     if (log_record_type == LogRecordType::INSERT) {
       insert_rid_ = rid;
@@ -83,7 +83,7 @@ public:
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type,
             const RID &update_rid, const Tuple &old_tuple,
             const Tuple &new_tuple)
-      : lsn_(INVALID_LSN), txn_id_(txn_id), prev_lsn_(prev_lsn),
+      : txn_id_(txn_id), lsn_(INVALID_LSN), prev_lsn_(prev_lsn),
         log_record_type_(log_record_type), update_rid_(update_rid),
         old_tuple_(old_tuple), new_tuple_(new_tuple) {
     // calculate log record size
@@ -94,7 +94,7 @@ public:
   // constructor for NEWPAGE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type,
             page_id_t page_id)
-      : size_(HEADER_SIZE), lsn_(INVALID_LSN), txn_id_(txn_id),
+      : size_(HEADER_SIZE), txn_id_(txn_id), lsn_(INVALID_LSN),
         prev_lsn_(prev_lsn), log_record_type_(log_record_type),
         prev_page_id_(page_id) {
     // calculate log record size
@@ -137,9 +137,9 @@ public:
 private:
   // the length of log record(for serialization, in bytes)
   int32_t size_ = 0;
-  // must have fields
-  lsn_t lsn_ = INVALID_LSN;
+  // must have fields, ordered so that the header has no padding
   txn_id_t txn_id_ = INVALID_TXN_ID;
+  lsn_t lsn_ = INVALID_LSN;
   lsn_t prev_lsn_ = INVALID_LSN;
   LogRecordType log_record_type_ = LogRecordType::INVALID;
 
@@ -158,7 +158,7 @@ private:
 
   // case4: for new page opeartion
   page_id_t prev_page_id_ = INVALID_PAGE_ID;
-  const static int HEADER_SIZE = 20;
+  const static int HEADER_SIZE = 28;
 }; // namespace cmudb
 
 } // namespace cmudb
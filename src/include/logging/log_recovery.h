@@ -41,9 +41,9 @@ private:
   // maintain active transactions and its corresponds latest lsn
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   // mapping log sequence number to log file offset, for undo purpose
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  std::unordered_map<lsn_t, off_t> lsn_mapping_;
   // log buffer related
-  int offset_;
+  off_t offset_;
   char *log_buffer_;
 };
 
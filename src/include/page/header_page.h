@@ -7,7 +7,7 @@
  *
  * Format (size in byte):
  *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
+ * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (8) | ... |
  *  -----------------------------------------------------------------
  */
 
@@ -32,6 +32,8 @@ public:
   // return root_id if success
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
+  // depends on the page size
+  static inline int GetMaxRecordCount() { return (PAGE_SIZE - 4) / 40; }
 
 private:
   /**
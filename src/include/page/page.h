@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
 
@@ -16,12 +18,25 @@
 
 namespace cmudb {
 
-class Page {
+// how hard the buffer pool tries to keep a page, given when it is fetched. The
+// highest hint since the page was loaded counts
+enum PageHint {
+  PAGE_HINT_NORMAL = 0,  // heap and leaf pages
+  PAGE_HINT_INDEX_INNER, // inner pages of an index
+  PAGE_HINT_HOT,         // index roots and the header page
+};
+
+// the metadata of a frame of the buffer pool, the page data is elsewhere. Every
+// page starts a cache line, so that threads using neighbouring pages don't
+// invalidate each other's lines
+class alignas(CACHE_LINE_SIZE) Page {
+  friend class BufferPoolInstance;
   friend class BufferPoolManager;
+  friend class VMCache;
 
 public:
-  Page() { ResetMemory(); }
-  ~Page(){};
+  Page() {}
+  ~Page() { delete[] child_refs_.load(); }
   // get actual data page content
   inline char *GetData() { return data_; }
   // get page id
@@ -34,17 +49,35 @@ public:
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
 
-  inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
-  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
+  // every kind of page keeps its LSN at the same offset
+  inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 8); }
+  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 8, &lsn, sizeof(lsn)); }
 
 private:
   // method used by buffer pool manager
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
+  char *data_ = nullptr; // actual data, usually frame_
+  char *frame_ = nullptr; // the memory owned by buffer pool manager
+  // read without the latch of the buffer pool by swizzled fetches
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
+  // loaded, and may be pinned through a swizzled reference
+  std::atomic<bool> resident_{false};
+  std::atomic<bool> in_replacer_{false};
+  // used through a swizzled reference since the replacer last heard of it
+  std::atomic<bool> referenced_{false};
+  // swizzled references to the children of an index page, allocated on first
+  // use and kept by the frame whatever page it holds
+  std::atomic<std::atomic<Page *> *> child_refs_{nullptr};
   bool is_dirty_ = false;
+  // being read or written back, waited for on io_done_ with the latch of the
+  // buffer pool
+  bool io_in_progress_ = false;
+  std::condition_variable io_done_;
+  int io_waiters_ = 0; // threads waiting on io_done_
+  uint64_t last_used_ = 0; // when the page was last pinned, per pool instance
+  PageHint hint_ = PAGE_HINT_NORMAL;
   RWMutex rwlatch_;
 };
 
@@ -10,7 +10,7 @@
  *
  *  Header format (size in byte):
  *  --------------------------------------------------------------------------
- * | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
+ * | PageId (8)| LSN (8)| PrevPageId (8)| NextPageId (8)| FreeSpacePointer(4) |
  *  --------------------------------------------------------------------------
  *  --------------------------------------------------------------
  * | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
@@ -24,9 +24,9 @@ public:
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
             LogManager *log_manager, page_id_t first_page_id);
 
-  // create table heap
+  // create table heap, its pages are allocated in the given tablespace
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
-            LogManager *log_manager, Transaction *txn);
+            LogManager *log_manager, Transaction *txn, int tablespace = 0);
 
   // for insert, if tuple is too large (>~page_size), return false
   bool InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn);
@@ -46,7 +46,10 @@ public:
 
   bool DeleteTableHeap();
 
-  TableIterator begin(Transaction *txn);
+  // a large scan should read the pages through a ring of its own, see
+  // buffer_access_strategy.h
+  TableIterator begin(Transaction *txn,
+                      BufferAccessStrategy *strategy = nullptr);
 
   TableIterator end();
 
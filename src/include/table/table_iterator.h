@@ -8,6 +8,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +20,10 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  // strategy: pages are read through this ring if not nullptr, it must
+  // outlive the iterator
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                BufferAccessStrategy *strategy = nullptr);
 
   ~TableIterator() { delete tuple_; }
 
@@ -43,6 +47,8 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  BufferAccessStrategy *strategy_;
+  page_id_t prefetched_end_; // see BufferPoolManager::PrefetchWindow
 };
 
 } // namespace cmudb
\ No newline at end of file
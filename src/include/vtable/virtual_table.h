@@ -59,20 +59,31 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+// SQL function buffer_pool_size([pages]): resize the buffer pool if given a
+// size, return the size of the pool
+void BufferPoolSizeFunc(sqlite3_context *ctx, int argc, sqlite3_value **argv);
+
 // storage engine
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  // pool_size: pages in the buffer pool, it can be changed later on
+  StorageEngine(std::string db_file_name,
+                size_t pool_size = BUFFER_POOL_SIZE) {
     ENABLE_LOGGING = false;
 
     // storage related
     disk_manager_ = new DiskManager(db_file_name);
+    io_scheduler_ = new IOScheduler(disk_manager_);
 
     // log related
-    log_manager_ = new LogManager(disk_manager_);
+    log_manager_ = new LogManager(disk_manager_, io_scheduler_);
 
-    buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    buffer_pool_manager_ = new BufferPoolManager(pool_size, disk_manager_,
+                                                 log_manager_, io_scheduler_);
+    buffer_pool_manager_->StartBackgroundWriter(pool_size / 10);
+    // warm up with the pages that were in the pool at the last shutdown
+    hot_set_file_ = db_file_name.substr(0, db_file_name.find(".")) + ".hot";
+    buffer_pool_manager_->PreloadHotSet(hot_set_file_);
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -82,18 +93,23 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    buffer_pool_manager_->DumpHotSet(hot_set_file_);
     delete buffer_pool_manager_;
     delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
+    // after everything that may still queue I/O
+    delete io_scheduler_;
+    delete disk_manager_;
   }
 
   DiskManager *disk_manager_;
+  IOScheduler *io_scheduler_;
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
+  std::string hot_set_file_;
 };
 
 StorageEngine *storage_engine_;
@@ -172,7 +188,9 @@ public:
     return table_heap_->UpdateTuple(tuple, rid, GetTransaction());
   }
 
-  inline TableIterator begin() { return table_heap_->begin(GetTransaction()); }
+  inline TableIterator begin(BufferAccessStrategy *strategy = nullptr) {
+    return table_heap_->begin(GetTransaction(), strategy);
+  }
 
   inline TableIterator end() { return table_heap_->end(); }
 
@@ -197,7 +215,8 @@ private:
 class Cursor {
 public:
   Cursor(VirtualTable *virtual_table)
-      : table_iterator_(virtual_table->begin()), virtual_table_(virtual_table) {
+      : table_iterator_(virtual_table->begin(&scan_ring_)),
+        virtual_table_(virtual_table) {
   }
 
   inline void SetScanFlag(bool is_index_scan) {
@@ -257,7 +276,8 @@ private:
   // for index scan
   std::vector<RID> results;
   int offset_ = 0;
-  // for sequential scan
+  // for sequential scan, which reads through a ring of its own
+  BufferAccessStrategy scan_ring_;
   TableIterator table_iterator_;
   // flag to indicate which scan method is currently used
   bool is_index_scan_ = false;
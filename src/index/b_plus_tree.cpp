@@ -15,8 +15,9 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(const std::string &name,
                           BufferPoolManager *buffer_pool_manager,
                           const KeyComparator &comparator,
-                          page_id_t root_page_id)
-    : index_name_(name), root_page_id_(root_page_id),
+                          page_id_t root_page_id, int tablespace)
+    : index_name_(name), root_page_id_(root_page_id), leaf_depth_(0),
+      root_ref_(nullptr), tablespace_(tablespace),
       buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
 
 /*
@@ -87,7 +88,8 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value, Tr
 
     if (root_page_id_ == INVALID_PAGE_ID) {
       page_id_t page_id;
-      Page *page = buffer_pool_manager_->NewPage(page_id);
+      Page *page = buffer_pool_manager_->NewPage(
+          page_id, TablespaceHint(tablespace_), PAGE_HINT_HOT);
       B_PLUS_TREE_LEAF_PAGE_TYPE *lp = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
       lp->Init(page_id, INVALID_PAGE_ID);
       buffer_pool_manager_->UnpinPage(page_id, true);
@@ -142,7 +144,10 @@ INDEX_TEMPLATE_ARGUMENTS
 template<typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
   page_id_t page_id;
-  Page *page = buffer_pool_manager_->NewPage(page_id);
+  // keep the new sibling in the extent of the node
+  Page *page = buffer_pool_manager_->NewPage(
+      page_id, node->GetPageId(),
+      node->IsLeafPage() ? PAGE_HINT_NORMAL : PAGE_HINT_INDEX_INNER);
   if (page == nullptr) {
     throw std::bad_alloc();
   }
@@ -170,7 +175,8 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
   page_id_t parent_pid = old_node->GetParentPageId();
   if (parent_pid == INVALID_PAGE_ID) {
     std::lock_guard<std::mutex> guard(mutex_);
-    Page *page = buffer_pool_manager_->NewPage(parent_pid);
+    Page *page = buffer_pool_manager_->NewPage(
+        parent_pid, old_node->GetPageId(), PAGE_HINT_HOT);
     if (page == nullptr) {
       throw std::bad_alloc();
     }
@@ -186,7 +192,8 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
     return;
   }
 
-  Page *page = buffer_pool_manager_->FetchPage(parent_pid);
+  Page *page =
+      buffer_pool_manager_->FetchPage(parent_pid, PAGE_HINT_INDEX_INNER);
   BPlusTreeParentPage *parent = reinterpret_cast<BPlusTreeParentPage *>(page->GetData());
   //insert new kv pair points to new_node after that
   parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
@@ -261,10 +268,12 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     return AdjustRoot(node);
   }
 
-  Page *page = buffer_pool_manager_->FetchPage(parent_id);
+  Page *page =
+      buffer_pool_manager_->FetchPage(parent_id, PAGE_HINT_INDEX_INNER);
   BPlusTreeParentPage *parent = reinterpret_cast<BPlusTreeParentPage *>(page->GetData());
   const int idx = parent->ValueIndex(btree_page->GetPageId());
 
+  PageHint hint = node->IsLeafPage() ? PAGE_HINT_NORMAL : PAGE_HINT_INDEX_INNER;
   N *left_sib = nullptr;
   N *right_sib = nullptr;
   page_id_t left_sib_pid = INVALID_PAGE_ID;
@@ -272,7 +281,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
 
   if (idx >= 1) {
     left_sib_pid = parent->ValueAt(idx - 1);
-    Page *page = buffer_pool_manager_->FetchPage(left_sib_pid);
+    Page *page = buffer_pool_manager_->FetchPage(left_sib_pid, hint);
     if (transaction) {
       page->WLatch();
       transaction->AddIntoPageSet(page);
@@ -290,7 +299,7 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
 
   if (idx + 1 < parent->GetSize()) {
     right_sib_pid = parent->ValueAt(idx + 1);
-    Page *page = buffer_pool_manager_->FetchPage(right_sib_pid);
+    Page *page = buffer_pool_manager_->FetchPage(right_sib_pid, hint);
     if (transaction != nullptr) {
       page->WLatch();
       transaction->AddIntoPageSet(page);
@@ -415,7 +424,8 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
       //case 1
       BPlusTreeParentPage *parent = reinterpret_cast<BPlusTreeParentPage *>(old_root_node);
       root_page_id_ = parent->ValueAt(0);
-      Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+      Page *page =
+          buffer_pool_manager_->FetchPage(root_page_id_, PAGE_HINT_HOT);
       BPlusTreePage *new_root = reinterpret_cast<BPlusTreePage *>(page->GetData());
       new_root->SetParentPageId(INVALID_PAGE_ID);
       UpdateRootPageId(false);
@@ -435,10 +445,11 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(BufferAccessStrategy *strategy) {
   KeyType key;
   B_PLUS_TREE_LEAF_PAGE_TYPE *page = FindLeafPage(key, nullptr, kFind, true);
-  return INDEXITERATOR_TYPE(page->GetPageId(), 0, *buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(page->GetPageId(), 0, *buffer_pool_manager_,
+                            strategy);
 }
 
 /*
@@ -447,10 +458,12 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key,
+                                         BufferAccessStrategy *strategy) {
   B_PLUS_TREE_LEAF_PAGE_TYPE *leaf = FindLeafPage(key);
   buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
-  return INDEXITERATOR_TYPE(leaf->GetPageId(), leaf->KeyIndex(key, comparator_), *buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(leaf->GetPageId(), leaf->KeyIndex(key, comparator_), *buffer_pool_manager_,
+                            strategy);
 }
 
 /*****************************************************************************
@@ -471,7 +484,8 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
   std::unique_lock<std::mutex> lock(mutex_);
   assert(root_page_id_ != INVALID_PAGE_ID);
   page_id_t page_id = root_page_id_;
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  Page *page = buffer_pool_manager_->FetchPage(page_id, root_ref_,
+                                               PAGE_HINT_HOT);
   assert(page);
   lock.unlock();
 
@@ -487,9 +501,10 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
       } else {
         page->RUnlatch();
       }
-      buffer_pool_manager_->UnpinPage(page_id, false);
+      buffer_pool_manager_->UnpinFrame(page, false);
       page_id = root_page_id_;
-      page = buffer_pool_manager_->FetchPage(page_id);
+      page = buffer_pool_manager_->FetchPage(page_id, root_ref_,
+                                             PAGE_HINT_HOT);
       if (op_type != kFind) {
         page->WLatch();
       } else {
@@ -501,12 +516,19 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 
   BPlusTreePage *btree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
 
+  int depth = 0;
   while (!btree_page->IsLeafPage()) {
     BPlusTreeParentPage *ip = reinterpret_cast<BPlusTreeParentPage *>(btree_page);
-    page_id_t unpin = page_id;
-
-    page_id = leftMost ? ip->ValueAt(0) : ip->Lookup(key, comparator_);
-    page = buffer_pool_manager_->FetchPage(page_id);
+    Page *unpin = page;
+
+    int index = leftMost ? 0 : ip->LookupIndex(key, comparator_);
+    page_id = ip->ValueAt(index);
+    // through the swizzled reference of the slot, so that a hot tree is
+    // walked without page table lookups. The leaves were deeper than that
+    // last time
+    page = buffer_pool_manager_->FetchPage(
+        page_id, buffer_pool_manager_->GetChildRefs(unpin)[index],
+        ++depth < leaf_depth_ ? PAGE_HINT_INDEX_INNER : PAGE_HINT_NORMAL);
     btree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
     if (transaction) {
       if (op_type != kFind) {
@@ -529,10 +551,11 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
       }
       transaction->AddIntoPageSet(page);
     } else {
-      buffer_pool_manager_->UnpinPage(unpin, false);
+      buffer_pool_manager_->UnpinFrame(unpin, false);
     }
   }
   assert(btree_page);
+  leaf_depth_ = depth;
   return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(btree_page);
 }
 
@@ -579,7 +602,7 @@ void BPLUSTREE_TYPE::ReleaseAllLatches(Transaction *transaction,
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   HeaderPage *header_page = static_cast<HeaderPage *>(
-      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID, PAGE_HINT_HOT));
   if (insert_record)
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -12,8 +12,10 @@ namespace cmudb {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, int idx, BufferPoolManager &buff) :
-  pos_(idx), buffer_pool_(buff) {
+INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, int idx, BufferPoolManager &buff,
+                                  BufferAccessStrategy *strategy) :
+  pos_(idx), buffer_pool_(buff), strategy_(strategy),
+  prefetched_end_(INVALID_PAGE_ID) {
   leaf_page_ = GetLeafPage(page_id);
   end_ = leaf_page_->GetSize() <= pos_;
 }
@@ -29,7 +29,11 @@ void LogManager::FlushThread() {
       std::swap(flush_buffer_, log_buffer_);
       flush_buffer_size_ = log_buffer_size_;
       log_buffer_size_ = 0;
-      disk_manager_->WriteLog(flush_buffer_, flush_buffer_size_);
+      if (io_scheduler_ != nullptr) {
+        io_scheduler_->WriteLog(flush_buffer_, flush_buffer_size_).wait();
+      } else {
+        disk_manager_->WriteLog(flush_buffer_, flush_buffer_size_);
+      }
       int32_t size = 0;
       while (size < flush_buffer_size_) {
         auto rec = reinterpret_cast<LogRecord *>(flush_buffer_ + size);
@@ -75,10 +79,10 @@ void LogManager::FlushImpl() {
  *
  *
  * example below
- * // First, serialize the must have fields(20 bytes in total)
+ * // First, serialize the must have fields(28 bytes in total)
  * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
+ * memcpy(log_buffer_ + offset_, &log_record, 28);
+ * int pos = offset_ + 28;
  *
  * if (log_record.log_record_type_ == LogRecordType::INSERT) {
  *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
@@ -91,7 +95,7 @@ void LogManager::FlushImpl() {
 lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
   std::unique_lock<std::mutex> guard(append_latch_);
   log_record.lsn_ = next_lsn_++;
-  if (log_record.GetSize() + log_buffer_size_ > LOG_BUFFER_SIZE) {
+  if (log_record.GetSize() + log_buffer_size_ > log_buffer_capacity_) {
     Flush();
   }
   int pos = log_buffer_size_;
@@ -129,7 +129,7 @@ void LogRecovery::Redo() {
         buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
       }
 
-      lsn_mapping_[record.GetLSN()] = static_cast<int> (data - log_buffer_ + fetchCnt++ * LOG_BUFFER_SIZE);
+      lsn_mapping_[record.GetLSN()] = (data - log_buffer_) + static_cast<off_t>(fetchCnt++) * LOG_BUFFER_SIZE;
       data += record.size_;
       size -= record.size_;
     }
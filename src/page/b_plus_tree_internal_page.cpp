@@ -73,12 +73,21 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
 /*
  * Find and return the child pointer(page_id) which points to the child page
  * that contains input "key"
- * Start the search from the second key(the first key should always be invalid)
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
+  return array[LookupIndex(key, comparator)].second;
+}
+
+/*
+ * Same, but return the index of the child pointer
+ * Start the search from the second key(the first key should always be invalid)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
   int start = 1;
   int end = GetSize();
   while (start < end) {
@@ -90,7 +99,7 @@ B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
     }
   }
 
-  return array[start - 1].second;
+  return start - 1;
 }
 
 /*****************************************************************************
@@ -152,7 +161,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
   recipient->IncreaseSize(length - start);
   for (int i = 0; i < recipient->GetSize(); i++) {
     page_id_t page_id = recipient->ValueAt(i);
-    BPlusTreePage *page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(page_id));
+    BPlusTreePage *page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(page_id)->GetData());
     page->SetParentPageId(recipient->GetPageId());
     buffer_pool_manager->UnpinPage(page_id, true);
   }
@@ -191,7 +200,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
   assert(recipient->GetParentPageId() == GetParentPageId());
   int len = GetSize() + recipient->GetSize();
   Page *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page);
+  BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
   KeyType key = parent->KeyAt(index_in_parent);
 
   if (comparator(FirstKey(), recipient->FirstKey()) == -1) {
@@ -238,7 +247,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
   IncreaseSize(-1);
 
   Page *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page);
+  BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
   int index = parent->ValueIndex(GetPageId());
   recipient->SetKeyAt(recipient->GetSize() - 1, parent->KeyAt(index));
   parent->SetKeyAt(index, KeyAt(0));
@@ -246,7 +255,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
 
   page_id_t new_page_id = recipient->ValueAt(recipient->GetSize() - 1);
   page = buffer_pool_manager->FetchPage(new_page_id);
-  BPlusTreeInternalPage *new_page = reinterpret_cast<BPlusTreeInternalPage *>(page);
+  BPlusTreeInternalPage *new_page = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
   new_page->SetParentPageId(recipient->GetPageId());
   buffer_pool_manager->UnpinPage(new_page_id, true);
 }
@@ -268,7 +277,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
   recipient->IncreaseSize(1);
   IncreaseSize(-1);
   Page *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page);
+  BPlusTreeInternalPage *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
   int index = parent->ValueIndex(recipient->GetPageId());
   recipient->SetKeyAt(1, parent->KeyAt(index));
   parent->SetKeyAt(index, recipient->KeyAt(0));
@@ -277,7 +286,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
 
   page_id_t new_page_id = recipient->ValueAt(0);
   page = buffer_pool_manager->FetchPage(new_page_id);
-  BPlusTreeInternalPage *new_page = reinterpret_cast<BPlusTreeInternalPage *>(page);
+  BPlusTreeInternalPage *new_page = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
   new_page->SetParentPageId(recipient->GetPageId());
   buffer_pool_manager->UnpinPage(new_page_id, true);
 }
@@ -17,13 +17,16 @@ bool HeaderPage::InsertRecord(const std::string &name,
   assert(root_id > INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
-  int offset = 4 + record_num * 36;
+  int offset = 4 + record_num * 40;
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
+  // the page is full
+  if (record_num >= GetMaxRecordCount())
+    return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
-  memcpy((GetData() + offset + 32), &root_id, 4);
+  memcpy((GetData() + offset + 32), &root_id, sizeof(page_id_t));
 
   SetRecordCount(record_num + 1);
   return true;
@@ -37,9 +40,9 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
-  memmove(GetData() + offset, GetData() + offset + 36,
-          (record_num - index - 1) * 36);
+  int offset = index * 40 + 4;
+  memmove(GetData() + offset, GetData() + offset + 40,
+          (record_num - index - 1) * 40);
 
   SetRecordCount(record_num - 1);
   return true;
@@ -53,9 +56,9 @@ bool HeaderPage::UpdateRecord(const std::string &name,
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
+  int offset = index * 40 + 4;
   // update record content, only root_id
-  memcpy((GetData() + offset + 32), &root_id, 4);
+  memcpy((GetData() + offset + 32), &root_id, sizeof(page_id_t));
 
   return true;
 }
@@ -67,8 +70,9 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = (index + 1) * 36;
-  root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
+  int offset = index * 40 + 4;
+  // not aligned
+  memcpy(&root_id, GetData() + offset + 32, sizeof(page_id_t));
 
   return true;
 }
@@ -87,7 +91,7 @@ int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 36));
+    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 40));
     if (strcmp(raw_name, name.c_str()) == 0)
       return i;
   }
@@ -13,7 +13,7 @@ namespace cmudb {
 void TablePage::Init(page_id_t page_id, size_t page_size,
                      page_id_t prev_page_id, LogManager *log_manager,
                      Transaction *txn) {
-  memcpy(GetData(), &page_id, 4); // set page_id
+  memcpy(GetData(), &page_id, 8); // set page_id
   if (ENABLE_LOGGING) {
     LogRecord rec(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, page_id);
     log_manager->AppendLogRecord(rec);
@@ -31,19 +31,19 @@ page_id_t TablePage::GetPageId() {
 }
 
 page_id_t TablePage::GetPrevPageId() {
-  return *reinterpret_cast<page_id_t *>(GetData() + 8);
+  return *reinterpret_cast<page_id_t *>(GetData() + 16);
 }
 
 page_id_t TablePage::GetNextPageId() {
-  return *reinterpret_cast<page_id_t *>(GetData() + 12);
+  return *reinterpret_cast<page_id_t *>(GetData() + 24);
 }
 
 void TablePage::SetPrevPageId(page_id_t prev_page_id) {
-  memcpy(GetData() + 8, &prev_page_id, 4);
+  memcpy(GetData() + 16, &prev_page_id, 8);
 }
 
 void TablePage::SetNextPageId(page_id_t next_page_id) {
-  memcpy(GetData() + 12, &next_page_id, 4);
+  memcpy(GetData() + 24, &next_page_id, 8);
 }
 
 /**
@@ -373,41 +373,41 @@ bool TablePage::GetNextTupleRid(const RID &cur_rid, RID &next_rid) {
 
 // tuple slots
 int32_t TablePage::GetTupleOffset(int slot_num) {
-  return *reinterpret_cast<int32_t *>(GetData() + 24 + 8 * slot_num);
+  return *reinterpret_cast<int32_t *>(GetData() + 40 + 8 * slot_num);
 }
 
 int32_t TablePage::GetTupleSize(int slot_num) {
-  return *reinterpret_cast<int32_t *>(GetData() + 28 + 8 * slot_num);
+  return *reinterpret_cast<int32_t *>(GetData() + 44 + 8 * slot_num);
 }
 
 void TablePage::SetTupleOffset(int slot_num, int32_t offset) {
-  memcpy(GetData() + 24 + 8 * slot_num, &offset, 4);
+  memcpy(GetData() + 40 + 8 * slot_num, &offset, 4);
 }
 
 void TablePage::SetTupleSize(int slot_num, int32_t offset) {
-  memcpy(GetData() + 28 + 8 * slot_num, &offset, 4);
+  memcpy(GetData() + 44 + 8 * slot_num, &offset, 4);
 }
 
 // free space
 int32_t TablePage::GetFreeSpacePointer() {
-  return *reinterpret_cast<int32_t *>(GetData() + 16);
+  return *reinterpret_cast<int32_t *>(GetData() + 32);
 }
 
 void TablePage::SetFreeSpacePointer(int32_t free_space_pointer) {
-  memcpy(GetData() + 16, &free_space_pointer, 4);
+  memcpy(GetData() + 32, &free_space_pointer, 4);
 }
 
 // tuple count
 int32_t TablePage::GetTupleCount() {
-  return *reinterpret_cast<int32_t *>(GetData() + 20);
+  return *reinterpret_cast<int32_t *>(GetData() + 36);
 }
 
 void TablePage::SetTupleCount(int32_t tuple_count) {
-  memcpy(GetData() + 20, &tuple_count, 4);
+  memcpy(GetData() + 36, &tuple_count, 4);
 }
 
 // for free space calculation
 int32_t TablePage::GetFreeSpaceSize() {
-  return GetFreeSpacePointer() - 24 - GetTupleCount() * 8;
+  return GetFreeSpacePointer() - 40 - GetTupleCount() * 8;
 }
 } // namespace cmudb
@@ -3,6 +3,7 @@
  */
 
 #include <cassert>
+#include <cinttypes>
 
 #include "common/logger.h"
 #include "table/table_heap.h"
@@ -19,14 +20,15 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
 // create table
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
                      LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
+                     Transaction *txn, int tablespace)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
       log_manager_(log_manager) {
-  auto first_page =
-      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
+  // the following pages are allocated near this one
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(
+      first_page_id_, TablespaceHint(tablespace)));
   assert(first_page != nullptr); // todo: abort table creation?
   first_page->WLatch();
-  LOG_DEBUG("new table page created %d", first_page_id_);
+  LOG_DEBUG("new table page created %" PRId64, first_page_id_);
 
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
   first_page->WUnlatch();
@@ -34,7 +36,7 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) { // larger than one page size
+  if (tuple.size_ + 48 > PAGE_SIZE) { // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
@@ -59,7 +61,8 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
       cur_page->WLatch();
     } else { // create new page
       auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
+          static_cast<TablePage *>(buffer_pool_manager_->NewPage(
+              next_page_id, cur_page->GetPageId()));
       if (new_page == nullptr) {
         cur_page->WUnlatch();
         buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
@@ -154,14 +157,33 @@ bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn) {
   return res;
 }
 
+// drop table, return all the pages of the heap to the disk manager
 bool TableHeap::DeleteTableHeap() {
-  // todo: real delete
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr)
+      return false;
+    page->RLatch();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    // fails if someone else still has the page pinned
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      first_page_id_ = page_id;
+      return false;
+    }
+    page_id = next_page_id;
+  }
+  first_page_id_ = INVALID_PAGE_ID;
   return true;
 }
 
-TableIterator TableHeap::begin(Transaction *txn) {
-  auto page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+TableIterator TableHeap::begin(Transaction *txn,
+                                BufferAccessStrategy *strategy) {
+  auto page = static_cast<TablePage *>(
+      buffer_pool_manager_->FetchPage(first_page_id_, strategy));
   page->RLatch();
   RID rid;
   // if failed (no tuple), rid will be the result of default
@@ -169,7 +191,7 @@ TableIterator TableHeap::begin(Transaction *txn) {
   page->GetFirstTupleRid(rid);
   page->RUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  return TableIterator(this, rid, txn, strategy);
 }
 
 TableIterator TableHeap::end() {
@@ -2,6 +2,7 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <sys/stat.h>
@@ -26,8 +27,8 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   LogManager *log_manager = storage_engine_->log_manager_;
 
   // fetch header page from buffer pool
-  HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  HeaderPage *header_page = static_cast<HeaderPage *>(
+      buffer_pool_manager->FetchPage(HEADER_PAGE_ID, PAGE_HINT_HOT));
 
   // the first three parameter:(1) module name (2) database name (3)table name
   assert(argc >= 4);
@@ -77,8 +78,8 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   LogManager *log_manager = storage_engine_->log_manager_;
 
   // Retrieve table root page info from header page
-  HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  HeaderPage *header_page = static_cast<HeaderPage *>(
+      buffer_pool_manager->FetchPage(HEADER_PAGE_ID, PAGE_HINT_HOT));
   page_id_t table_root_id;
   header_page->GetRootId(std::string(argv[2]), table_root_id);
   // parse arg[4](string that defines table index)
@@ -322,6 +323,20 @@ int VtabCommit(sqlite3_vtab *pVTab) {
   return SQLITE_OK;
 }
 
+void BufferPoolSizeFunc(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+  auto buffer_pool_manager = storage_engine_->buffer_pool_manager_;
+  if (argc == 1) {
+    sqlite3_int64 pool_size = sqlite3_value_int64(argv[0]);
+    if (pool_size <= 0) {
+      sqlite3_result_error(ctx, "buffer pool size must be positive", -1);
+      return;
+    }
+    sqlite3_result_int64(ctx, buffer_pool_manager->Resize(pool_size));
+    return;
+  }
+  sqlite3_result_int64(ctx, buffer_pool_manager->GetPoolSize());
+}
+
 sqlite3_module VtableModule = {
     0,              /* iVersion */
     VtabCreate,     /* xCreate */
@@ -358,8 +373,12 @@ __declspec(dllexport)
   struct stat buffer;
   bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
 
-  // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
+  // init storage engine, the buffer pool size can be set in the environment
+  size_t pool_size = BUFFER_POOL_SIZE;
+  const char *pool_size_env = getenv("VTABLE_BUFFER_POOL_SIZE");
+  if (pool_size_env != nullptr && atol(pool_size_env) > 0)
+    pool_size = atol(pool_size_env);
+  storage_engine_ = new StorageEngine(db_file_name, pool_size);
   // start the logging
   storage_engine_->log_manager_->RunFlushThread();
   // create header page from BufferPoolManager if necessary
@@ -372,6 +391,12 @@ __declspec(dllexport)
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc != SQLITE_OK)
+    return rc;
+  for (int argc = 0; argc <= 1 && rc == SQLITE_OK; argc++) {
+    rc = sqlite3_create_function(db, "buffer_pool_size", argc, SQLITE_UTF8,
+                                 nullptr, BufferPoolSizeFunc, nullptr, nullptr);
+  }
   return rc;
 }
 
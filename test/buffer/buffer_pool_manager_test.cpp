@@ -3,12 +3,81 @@
  */
 
 #include <cstdio>
+#include <chrono>
+#include <future>
+#include <thread>
 
 #include "buffer/buffer_pool_manager.h"
+#include "disk/io_scheduler.h"
 #include "gtest/gtest.h"
 
 namespace cmudb {
 
+// the read of page 5 waits until released
+class BlockingDiskManager : public DiskManager {
+public:
+  BlockingDiskManager(const std::string &db_file)
+      : DiskManager(db_file), released_(release_.get_future()) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (page_id == 5) {
+      reading_.set_value();
+      released_.wait();
+    }
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+  std::promise<void> reading_;
+  std::promise<void> release_;
+
+private:
+  std::shared_future<void> released_;
+};
+
+// counts the pages read and written
+class CountingDiskManager : public DiskManager {
+public:
+  CountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    num_reads_++;
+    DiskManager::ReadPage(page_id, page_data);
+  }
+  void ReadPages(page_id_t page_id, int count, char **pages) override {
+    num_reads_ += count;
+    DiskManager::ReadPages(page_id, count, pages);
+  }
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    num_writes_++;
+    DiskManager::WritePage(page_id, page_data);
+  }
+
+  std::atomic<int> num_reads_{0};
+  std::atomic<int> num_writes_{0};
+};
+
+// once armed, the write of page 0 waits until released
+class WriteBlockingDiskManager : public DiskManager {
+public:
+  WriteBlockingDiskManager(const std::string &db_file)
+      : DiskManager(db_file), released_(release_.get_future()) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (page_id == 0 && armed_) {
+      writing_.set_value();
+      released_.wait();
+    }
+    DiskManager::WritePage(page_id, page_data);
+  }
+
+  std::atomic<bool> armed_{false};
+  std::promise<void> writing_;
+  std::promise<void> release_;
+
+private:
+  std::shared_future<void> released_;
+};
+
 TEST(BufferPoolManagerTest, SampleTest) {
   page_id_t temp_page_id;
 
@@ -48,4 +117,741 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, ReadOnlyTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  for (int i = 0; i < 20; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+  }
+  for (int i = 0; i < 20; ++i)
+    bpm->FlushPage(i);
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db", DISK_READ_ONLY);
+  bpm = new BufferPoolManager(10, disk_manager);
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 19; i >= 0; --i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    // no copy, the page is the mapped file
+    EXPECT_EQ(disk_manager->GetMappedPage(i), page->GetData());
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, PartitionTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm =
+      new BufferPoolManager(16, disk_manager, nullptr, nullptr, 4);
+  EXPECT_EQ(4u, bpm->GetNumInstances());
+  // pages 0-7 go to the first instance, it has room for 4 of them
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  // the page was given back
+  EXPECT_FALSE(disk_manager->IsAllocated(4));
+  // the other instances still have room
+  for (int i = 1; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(8 * i));
+    EXPECT_TRUE(bpm->UnpinPage(8 * i, false));
+  }
+
+  EXPECT_FALSE(bpm->DeletePage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, true));
+  EXPECT_TRUE(bpm->DeletePage(0));
+  EXPECT_FALSE(disk_manager->IsAllocated(0));
+  for (int i = 1; i < 4; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+    EXPECT_TRUE(bpm->FlushPage(i));
+  }
+  delete bpm;
+
+  // a different number of instances sees the same pages
+  bpm = new BufferPoolManager(16, disk_manager, nullptr, nullptr, 2);
+  bpm->ReadAhead(0, 4);
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 1; i < 4; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, IOOutsideLatchTest) {
+  page_id_t temp_page_id;
+  BlockingDiskManager *disk_manager = new BlockingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->FlushPage(i);
+    bpm->UnpinPage(i, false);
+  }
+  delete bpm;
+  bpm = new BufferPoolManager(10, disk_manager);
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  bpm->UnpinPage(0, false);
+
+  std::future<Page *> first =
+      std::async(std::launch::async, [bpm] { return bpm->FetchPage(5); });
+  disk_manager->reading_.get_future().wait();
+  std::future<Page *> second =
+      std::async(std::launch::async, [bpm] { return bpm->FetchPage(5); });
+  // a hit does not wait for the read in progress, nor does a miss
+  Page *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  bpm->UnpinPage(1, false);
+  page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp("page 0", page->GetData()));
+  bpm->UnpinPage(0, false);
+
+  disk_manager->release_.set_value();
+  page = first.get();
+  ASSERT_NE(nullptr, page);
+  // the second fetch waited for the same frame
+  EXPECT_EQ(page, second.get());
+  EXPECT_EQ(2, page->GetPinCount());
+  EXPECT_EQ(0, strcmp("page 5", page->GetData()));
+  bpm->UnpinPage(5, false);
+  bpm->UnpinPage(5, false);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+static void ReplacerPolicyTest(ReplacerPolicy policy) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(
+      10, disk_manager, nullptr, nullptr, 1, policy);
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  for (int i = 0; i < 10; ++i)
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  // every page is written back and replaced
+  for (int i = 10; i < 20; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_TRUE(bpm->UnpinPage(temp_page_id, false));
+  }
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ReplacerPolicyTest) {
+  for (ReplacerPolicy policy : {CLOCK_REPLACER, LRU_K_REPLACER})
+    ReplacerPolicyTest(policy);
+}
+
+TEST(BufferPoolManagerTest, ScanRingTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  for (int i = 0; i < 50; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+    bpm->FlushPage(temp_page_id);
+  }
+  delete bpm;
+
+  bpm = new BufferPoolManager(20, disk_manager);
+  // the working set
+  for (int i = 40; i < 50; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  disk_manager->num_reads_ = 0;
+  // a scan through a ring of 4 pages
+  BufferAccessStrategy ring(4);
+  bpm->ReadAhead(0, 8, &ring);
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 0; i < 40; ++i) {
+    Page *page = bpm->FetchPage(i, &ring);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  // the scan was read once, and the working set is still in the pool
+  EXPECT_EQ(40, disk_manager->num_reads_);
+  for (int i = 40; i < 50; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(40, disk_manager->num_reads_);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, SmallPoolScanRingTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm =
+      new BufferPoolManager(10, disk_manager, nullptr, nullptr, 1);
+  for (int i = 0; i < 50; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+    bpm->FlushPage(temp_page_id);
+  }
+  delete bpm;
+
+  bpm = new BufferPoolManager(10, disk_manager, nullptr, nullptr, 1);
+  for (int i = 45; i < 50; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  disk_manager->num_reads_ = 0;
+  // the default ring is larger than the pool, it is cut down to fit
+  BufferAccessStrategy ring;
+  for (int i = 0; i < 45; ++i) {
+    Page *page = bpm->FetchPage(i, &ring);
+    ASSERT_NE(nullptr, page);
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(10u / SCAN_RING_POOL_FRACTION, ring.GetRingSize());
+  EXPECT_EQ(45, disk_manager->num_reads_);
+  for (int i = 45; i < 50; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(45, disk_manager->num_reads_);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+  }
+  bpm->StartBackgroundWriter(4, std::chrono::milliseconds(1));
+  for (int i = 0; i < 5000 && bpm->GetNumBackgroundWrites() < 4; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(4u, bpm->GetNumBackgroundWrites());
+  EXPECT_EQ(4, disk_manager->num_writes_);
+
+  // the misses take the free frames, without writing anything
+  for (int i = 10; i < 14; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    bpm->UnpinPage(temp_page_id, false);
+  }
+  EXPECT_EQ(4, disk_manager->num_writes_);
+
+  // the least recently used pages were written back
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ForegroundWriteBackTest) {
+  page_id_t temp_page_id;
+  WriteBlockingDiskManager *disk_manager =
+      new WriteBlockingDiskManager("test.db");
+  IOScheduler *scheduler = new IOScheduler(disk_manager);
+  scheduler->SetQueueDepth(IO_PRIORITY_WRITE, 1);
+  BufferPoolManager *bpm =
+      new BufferPoolManager(1, disk_manager, nullptr, scheduler, 1);
+  for (int i = 0; i < 2; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+  }
+
+  // a background write holds the only slot of the write class
+  char data[MAX_PAGE_SIZE];
+  snprintf(data, PAGE_SIZE, "page 0");
+  disk_manager->armed_ = true;
+  std::future<void> background = scheduler->WritePage(0, data);
+  disk_manager->writing_.get_future().wait();
+
+  // the miss writes back dirty page 1 without waiting for it
+  std::future<Page *> miss = std::async(std::launch::async, [bpm] {
+    page_id_t page_id;
+    return bpm->NewPage(page_id);
+  });
+  EXPECT_EQ(std::future_status::ready,
+            miss.wait_for(std::chrono::seconds(10)));
+  disk_manager->release_.set_value();
+  background.wait();
+  Page *page = miss.get();
+  ASSERT_NE(nullptr, page);
+  bpm->UnpinPage(page->GetPageId(), false);
+
+  page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp("page 1", page->GetData()));
+  bpm->UnpinPage(1, false);
+  delete bpm;
+  delete scheduler;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  for (int i = 0; i < 16; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+    bpm->FlushPage(temp_page_id);
+  }
+  delete bpm;
+
+  IOScheduler *scheduler = new IOScheduler(disk_manager);
+  bpm = new BufferPoolManager(20, disk_manager, nullptr, scheduler);
+  disk_manager->num_reads_ = 0;
+  bpm->PrefetchPages(0, 8);
+  // the pages are read once, by the prefetch
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    EXPECT_EQ(1, page->GetPinCount());
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(8, disk_manager->num_reads_);
+
+  // a scan keeps the window ahead of itself in flight
+  page_id_t window_end = INVALID_PAGE_ID;
+  bpm->PrefetchWindow(8, window_end);
+  EXPECT_EQ(8 + PREFETCH_WINDOW, window_end);
+  bpm->PrefetchWindow(9, window_end);
+  EXPECT_EQ(8 + PREFETCH_WINDOW, window_end);
+  bpm->PrefetchWindow(8 + PREFETCH_WINDOW / 2, window_end);
+  EXPECT_EQ(8 + PREFETCH_WINDOW * 3 / 2, window_end);
+  // may still be in flight
+  delete bpm;
+  EXPECT_EQ(16, disk_manager->num_reads_);
+
+  delete scheduler;
+  delete disk_manager;
+  remove("test.db");
+}
+
+static void ResizeTest(ReplacerPolicy policy) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(
+      10, disk_manager, nullptr, nullptr, 1, policy);
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  // pages 8 and 9 stay pinned
+  for (int i = 0; i < 8; ++i)
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+
+  EXPECT_EQ(20u, bpm->Resize(20));
+  for (int i = 10; i < 20; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(temp_page_id, true));
+  }
+
+  // the dirty pages that are dropped are written back
+  EXPECT_EQ(5u, bpm->Resize(5));
+  EXPECT_EQ(5u, bpm->GetPoolSize());
+  std::vector<page_id_t> ids;
+  Page *page;
+  while ((page = bpm->NewPage(temp_page_id)) != nullptr)
+    ids.push_back(temp_page_id);
+  EXPECT_EQ(3u, ids.size());
+  for (auto id : ids)
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 0; i < 20; ++i) {
+    page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // pinned pages are not dropped
+  EXPECT_EQ(2u, bpm->Resize(1));
+  EXPECT_TRUE(bpm->UnpinPage(8, false));
+  EXPECT_TRUE(bpm->UnpinPage(9, false));
+  EXPECT_EQ(1u, bpm->Resize(1));
+  EXPECT_EQ(12u, bpm->Resize(12));
+  for (int i = 0; i < 12; ++i)
+    EXPECT_NE(nullptr, bpm->FetchPage(i));
+  EXPECT_EQ(nullptr, bpm->FetchPage(12));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  for (ReplacerPolicy policy : {LRU_REPLACER, CLOCK_REPLACER, LRU_K_REPLACER})
+    ResizeTest(policy);
+}
+
+TEST(BufferPoolManagerTest, HotSetTest) {
+  page_id_t temp_page_id;
+  remove("test.hot");
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  for (int i = 0; i < 60; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+  }
+  // pages 20 to 39 end up in the pool, 39 used last
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_TRUE(bpm->DumpHotSet("test.hot"));
+  delete bpm;
+
+  // a smaller pool gets the most recently used pages
+  bpm = new BufferPoolManager(16, disk_manager);
+  disk_manager->num_reads_ = 0;
+  bpm->PreloadHotSet("test.hot", true);
+  EXPECT_EQ(16, disk_manager->num_reads_);
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 24; i < 40; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(16, disk_manager->num_reads_);
+  delete bpm;
+
+  // no hot set yet
+  bpm = new BufferPoolManager(16, disk_manager);
+  bpm->PreloadHotSet("missing.hot");
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.hot");
+}
+
+TEST(BufferPoolManagerTest, CompressedCacheTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(
+      5, disk_manager, nullptr, nullptr, 1, LRU_REPLACER, 1 << 20);
+  for (int i = 0; i < 20; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+  }
+  // the evicted pages come back from the cache, not from the disk
+  disk_manager->num_reads_ = 0;
+  char expected[MAX_PAGE_SIZE];
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 20; ++i) {
+      Page *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_EQ(0, strcmp(expected, page->GetData()));
+      if (i == 7) {
+        snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+        bpm->UnpinPage(i, true);
+      } else {
+        bpm->UnpinPage(i, false);
+      }
+    }
+  }
+  EXPECT_EQ(0, disk_manager->num_reads_);
+  EXPECT_EQ(40u, bpm->GetNumCacheHits());
+
+  // a deleted page doesn't come back
+  EXPECT_TRUE(bpm->DeletePage(3));
+  Page *page = bpm->NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(3, temp_page_id);
+  EXPECT_EQ(0, page->GetData()[0]);
+  bpm->UnpinPage(temp_page_id, false);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, CompressedCacheWriterTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(
+      10, disk_manager, nullptr, nullptr, 1, LRU_REPLACER, 1 << 20);
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(temp_page_id, true);
+  }
+  // the pages cleaned by the background writer are kept compressed
+  bpm->StartBackgroundWriter(4, std::chrono::milliseconds(1));
+  for (int i = 0; i < 5000 && bpm->GetNumBackgroundWrites() < 4; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  bpm->StopBackgroundWriter();
+  ASSERT_EQ(4u, bpm->GetNumBackgroundWrites());
+  disk_manager->num_reads_ = 0;
+  char expected[MAX_PAGE_SIZE];
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(0, disk_manager->num_reads_);
+  EXPECT_EQ(4u, bpm->GetNumCacheHits());
+  for (int i = 0; i < 10; ++i)
+    bpm->FlushPage(i);
+
+  delete bpm;
+
+  // and so are the pages that fall out of a scan ring
+  bpm = new BufferPoolManager(10, disk_manager, nullptr, nullptr, 1,
+                              LRU_REPLACER, 1 << 20);
+  BufferAccessStrategy ring(2);
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i, &ring));
+    bpm->UnpinPage(i, false);
+  }
+  disk_manager->num_reads_ = 0;
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(0, disk_manager->num_reads_);
+  EXPECT_EQ(4u, bpm->GetNumCacheHits());
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageHintTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  ASSERT_NE(nullptr, bpm->NewPage(temp_page_id, INVALID_PAGE_ID,
+                                  PAGE_HINT_HOT));
+  bpm->UnpinPage(temp_page_id, true);
+  for (int i = 1; i < 40; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    bpm->UnpinPage(temp_page_id, true);
+  }
+  // a scan through the other pages doesn't push the hot ones out
+  ASSERT_NE(nullptr, bpm->FetchPage(1, PAGE_HINT_INDEX_INNER));
+  bpm->UnpinPage(1, false);
+  disk_manager->num_reads_ = 0;
+  for (int i = 2; i < 40; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  int reads = disk_manager->num_reads_;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(reads, disk_manager->num_reads_);
+
+  // hinted pages are evicted when there is nothing else
+  for (int i = 2; i < 30; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i, PAGE_HINT_INDEX_INNER));
+    bpm->UnpinPage(i, false);
+  }
+  // the index root goes last
+  disk_manager->num_reads_ = 0;
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  bpm->UnpinPage(0, false);
+  EXPECT_EQ(0, disk_manager->num_reads_);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, SwizzleTest) {
+  page_id_t temp_page_id;
+  CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+  BufferPoolManager *bpm =
+      new BufferPoolManager(10, disk_manager, nullptr, nullptr, 1);
+  for (int i = 0; i < 40; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &temp_page_id, sizeof(temp_page_id));
+    bpm->UnpinPage(temp_page_id, true);
+  }
+
+  // looked up once, then pinned through the reference
+  std::atomic<Page *> ref(nullptr);
+  Page *page = bpm->FetchPage(39, ref);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(page, ref.load());
+  EXPECT_TRUE(bpm->UnpinFrame(page, false));
+  EXPECT_EQ(page, bpm->FetchPage(39, ref));
+  EXPECT_EQ(1, page->GetPinCount());
+
+  // a page pinned through a reference is not evicted
+  for (int i = 0; i < 9; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(9));
+  EXPECT_EQ(39, page->GetPageId());
+  EXPECT_TRUE(bpm->UnpinFrame(page, false));
+  for (int i = 0; i < 9; ++i) {
+    bpm->UnpinPage(i, false);
+  }
+  // its last unpin gave it back to the replacer
+  for (int i = 9; i < 19; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    bpm->UnpinPage(i, false);
+  }
+
+  // stale once the page is evicted, the page is looked up again
+  disk_manager->num_reads_ = 0;
+  page = bpm->FetchPage(39, ref);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, disk_manager->num_reads_);
+  EXPECT_EQ(page, ref.load());
+  EXPECT_EQ(39, page->GetPageId());
+  page_id_t page_id;
+  memcpy(&page_id, page->GetData(), sizeof(page_id));
+  EXPECT_EQ(39, page_id);
+  EXPECT_TRUE(bpm->UnpinFrame(page, false));
+
+  // pages pinned through references while others are evicted all the time
+  std::vector<std::atomic<Page *>> refs(40);
+  for (auto &r : refs) {
+    r = nullptr;
+  }
+  std::vector<std::thread> threads;
+  std::atomic<int> errors(0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([bpm, &refs, &errors, t] {
+      for (int n = 0; n < 2000; ++n) {
+        page_id_t page_id = (n * 7 + t) % 40;
+        Page *page = bpm->FetchPage(page_id, refs[page_id]);
+        if (page == nullptr) {
+          continue;
+        }
+        page_id_t stored;
+        memcpy(&stored, page->GetData(), sizeof(stored));
+        if (page->GetPageId() != page_id || stored != page_id) {
+          errors++;
+        }
+        bpm->UnpinFrame(page, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, errors);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, SwizzleRecencyTest) {
+  page_id_t temp_page_id;
+  for (auto policy : {LRU_REPLACER, CLOCK_REPLACER, LRU_K_REPLACER}) {
+    CountingDiskManager *disk_manager = new CountingDiskManager("test.db");
+    BufferPoolManager *bpm =
+        new BufferPoolManager(10, disk_manager, nullptr, nullptr, 1, policy);
+    for (int i = 0; i < 40; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+      bpm->UnpinPage(temp_page_id, true);
+    }
+
+    // page 0 is only used through its reference while the others go by, it
+    // stays as hot as if it was fetched by id
+    std::atomic<Page *> ref(nullptr);
+    Page *page = bpm->FetchPage(0, ref);
+    ASSERT_NE(nullptr, page);
+    bpm->UnpinFrame(page, false);
+    int page_reads = 0;
+    for (int i = 1; i < 40; ++i) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      bpm->UnpinPage(i, false);
+      int reads = disk_manager->num_reads_;
+      page = bpm->FetchPage(0, ref);
+      ASSERT_NE(nullptr, page);
+      bpm->UnpinFrame(page, false);
+      page_reads += disk_manager->num_reads_ - reads;
+    }
+    EXPECT_EQ(0, page_reads);
+
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
 } // namespace cmudb
@@ -0,0 +1,49 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  Page pages[6];
+  ClockReplacer clock_replacer(pages, 6);
+
+  // push element into replacer
+  for (int i = 0; i < 6; i++)
+    clock_replacer.Insert(&pages[i]);
+  clock_replacer.Insert(&pages[0]);
+  EXPECT_EQ(6u, clock_replacer.Size());
+
+  // every page was used, the first sweep only clears the reference bits
+  Page *value;
+  EXPECT_TRUE(clock_replacer.Victim(value));
+  EXPECT_EQ(&pages[0], value);
+  EXPECT_TRUE(clock_replacer.Victim(value));
+  EXPECT_EQ(&pages[1], value);
+
+  // page 2 is used again, it gets a second chance
+  EXPECT_TRUE(clock_replacer.Erase(&pages[2]));
+  clock_replacer.Insert(&pages[2]);
+  EXPECT_TRUE(clock_replacer.Victim(value));
+  EXPECT_EQ(&pages[3], value);
+
+  // remove element from replacer
+  EXPECT_FALSE(clock_replacer.Erase(&pages[3]));
+  EXPECT_TRUE(clock_replacer.Erase(&pages[4]));
+  EXPECT_EQ(2u, clock_replacer.Size());
+
+  // pop element from replacer after removal
+  EXPECT_TRUE(clock_replacer.Victim(value));
+  EXPECT_EQ(&pages[5], value);
+  EXPECT_TRUE(clock_replacer.Victim(value));
+  EXPECT_EQ(&pages[2], value);
+  EXPECT_FALSE(clock_replacer.Victim(value));
+  EXPECT_EQ(0u, clock_replacer.Size());
+}
+
+} // namespace cmudb
@@ -0,0 +1,67 @@
+/**
+ * compressed_cache_test.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "buffer/compressed_cache.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(CompressedCacheTest, SampleTest) {
+  CompressedCache cache(1 << 20);
+  std::vector<char> page(PAGE_SIZE, 0);
+  std::vector<char> buf(PAGE_SIZE);
+  snprintf(&page[0], PAGE_SIZE, "mostly free space");
+  cache.Put(1, &page[0]);
+  EXPECT_LT(0u, cache.GetSize());
+  EXPECT_GT(static_cast<size_t>(PAGE_SIZE / 2), cache.GetSize());
+  EXPECT_TRUE(cache.Get(1, &buf[0]));
+  EXPECT_EQ(0, memcmp(&page[0], &buf[0], PAGE_SIZE));
+  // taken out of the cache
+  EXPECT_FALSE(cache.Get(1, &buf[0]));
+  EXPECT_EQ(0u, cache.GetSize());
+  EXPECT_EQ(1u, cache.GetNumHits());
+
+  // not worth keeping
+  srand(0);
+  std::vector<char> noise(PAGE_SIZE);
+  for (auto &c : noise)
+    c = static_cast<char>(rand());
+  cache.Put(2, &noise[0]);
+  EXPECT_FALSE(cache.Get(2, &buf[0]));
+
+  // a newer image replaces the old one, an erased page is gone
+  cache.Put(3, &page[0]);
+  snprintf(&page[0], PAGE_SIZE, "newer image");
+  cache.Put(3, &page[0]);
+  cache.Put(4, &page[0]);
+  cache.Erase(4);
+  EXPECT_FALSE(cache.Get(4, &buf[0]));
+  EXPECT_TRUE(cache.Get(3, &buf[0]));
+  EXPECT_EQ(0, memcmp(&page[0], &buf[0], PAGE_SIZE));
+}
+
+TEST(CompressedCacheTest, EvictionTest) {
+  std::vector<char> page(PAGE_SIZE, 0);
+  std::vector<char> buf(PAGE_SIZE);
+  CompressedCache probe(1 << 20);
+  probe.Put(0, &page[0]);
+  size_t image_size = probe.GetSize();
+
+  // room for 3 images, the first ones put are dropped first
+  CompressedCache cache(3 * image_size);
+  for (int i = 0; i < 5; i++)
+    cache.Put(i, &page[0]);
+  EXPECT_EQ(3 * image_size, cache.GetSize());
+  EXPECT_FALSE(cache.Get(0, &buf[0]));
+  EXPECT_FALSE(cache.Get(1, &buf[0]));
+  for (int i = 2; i < 5; i++)
+    EXPECT_TRUE(cache.Get(i, &buf[0]));
+}
+
+} // namespace cmudb
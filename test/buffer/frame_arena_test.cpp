@@ -0,0 +1,43 @@
+/**
+ * frame_arena_test.cpp
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer/frame_arena.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+TEST(FrameArenaTest, SampleTest) {
+  // large enough for huge pages, if there are any
+  FrameArena arena(1000, 4096);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(arena.GetBase()) %
+                    DIRECT_IO_ALIGNMENT);
+  if (arena.UsesHugePages()) {
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(arena.GetBase()) %
+                      HUGE_PAGE_SIZE);
+  }
+  for (size_t i = 0; i < 1000; i++) {
+    char *frame = arena.GetFrame(i);
+    EXPECT_EQ(arena.GetBase() + i * 4096, frame);
+    EXPECT_EQ(0, frame[0]);
+    memset(frame, static_cast<int>(i), 4096);
+  }
+  EXPECT_EQ(static_cast<char>(999), arena.GetFrame(999)[4095]);
+
+  // a small pool
+  FrameArena small(3, 512);
+  memset(small.GetFrame(0), 'a', 3 * 512);
+}
+
+TEST(FrameArenaTest, PageLayoutTest) {
+  EXPECT_EQ(0u, sizeof(Page) % CACHE_LINE_SIZE);
+  Page pages[2];
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&pages[1]) % CACHE_LINE_SIZE);
+}
+
+} // namespace cmudb
@@ -0,0 +1,91 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 0, 4);
+
+  // page 1 is referenced twice, the others once
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  EXPECT_EQ(true, lru_k_replacer.Erase(1));
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(4);
+  EXPECT_EQ(4u, lru_k_replacer.Size());
+
+  // pages seen once go first, although page 1 is older
+  int value;
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+
+  // page 2 comes back, its history was retained
+  lru_k_replacer.Insert(2);
+  EXPECT_EQ(false, lru_k_replacer.Erase(3));
+  EXPECT_EQ(3u, lru_k_replacer.Size());
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+  // the second most recent reference of page 1 is older
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 1, 4);
+
+  // the second reference to page 5 is correlated to the first one
+  lru_k_replacer.Insert(5);
+  EXPECT_EQ(true, lru_k_replacer.Erase(5));
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Insert(7);
+
+  int value;
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(5, value);
+  // pages 6 and 7 were both referenced within the period
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(6, value);
+}
+
+TEST(LRUKReplacerTest, RingScanTest) {
+  const size_t history_size = 16;
+  LRUKReplacer<int> lru_k_replacer(2, 0, history_size);
+  lru_k_replacer.Insert(-1);
+  lru_k_replacer.Insert(-1);
+
+  // a scan through a ring of 4 frames, every page is given back to the free
+  // list instead of being evicted
+  for (int i = 0; i < 1000; i++) {
+    lru_k_replacer.Insert(i);
+    if (i >= 4) {
+      EXPECT_EQ(true, lru_k_replacer.Remove(i - 4));
+    }
+  }
+  EXPECT_LE(lru_k_replacer.GetHistorySize(), history_size + 5);
+  EXPECT_EQ(5u, lru_k_replacer.Size());
+
+  // the history of the page used all along is still there: the pages of the
+  // scan go first, but for the one just referenced
+  int value;
+  for (int i = 996; i < 999; i++) {
+    EXPECT_EQ(true, lru_k_replacer.Victim(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_EQ(true, lru_k_replacer.Victim(value));
+  EXPECT_EQ(-1, value);
+}
+
+} // namespace cmudb
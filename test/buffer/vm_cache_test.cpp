@@ -0,0 +1,115 @@
+/**
+ * vm_cache_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "buffer/vm_cache.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(VMCacheTest, SampleTest) {
+  remove("test.db");
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  VMCache *cache = new VMCache(10, disk_manager, nullptr, 1024);
+
+  Page *page_zero = cache->NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, cache->NewPage(temp_page_id));
+  }
+  // all the pages are pinned
+  EXPECT_EQ(nullptr, cache->NewPage(temp_page_id));
+  EXPECT_EQ(INVALID_PAGE_ID, temp_page_id);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(cache->UnpinPage(i, true));
+  }
+  EXPECT_FALSE(cache->UnpinPage(0, false));
+  // page zero is written back and evicted
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_NE(nullptr, cache->NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, cache->FetchPage(0));
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_TRUE(cache->UnpinPage(i, false));
+  }
+  page_zero = cache->FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+  // fetching a resident page gives the same frame
+  EXPECT_EQ(page_zero, cache->FetchPage(0));
+  EXPECT_FALSE(cache->DeletePage(0));
+  EXPECT_TRUE(cache->UnpinPage(0, false));
+  EXPECT_TRUE(cache->UnpinPage(0, false));
+  EXPECT_TRUE(cache->DeletePage(0));
+  EXPECT_TRUE(cache->FlushPage(5));
+  EXPECT_FALSE(cache->FlushPage(0));
+
+  // out of the reserved range
+  EXPECT_EQ(nullptr, cache->FetchPage(1024));
+
+  delete cache;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(VMCacheTest, ConcurrentTest) {
+  remove("test.db");
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  VMCache *cache = new VMCache(16, disk_manager, nullptr, 1024);
+  const int num_pages = 100;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = cache->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(cache->UnpinPage(temp_page_id, true));
+  }
+
+  // every thread increments a counter of its own in every page
+  const int num_threads = 4;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([cache, t] {
+      for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < num_pages; ++i) {
+          page_id_t page_id = (i * 7 + t * 13) % num_pages;
+          Page *page;
+          while ((page = cache->FetchPage(page_id)) == nullptr)
+            std::this_thread::yield();
+          char expected[32];
+          snprintf(expected, sizeof(expected), "page %d",
+                   static_cast<int>(page_id));
+          EXPECT_EQ(0, strcmp(expected, page->GetData()));
+          page->WLatch();
+          page->GetData()[64 + t]++;
+          page->WUnlatch();
+          cache->UnpinPage(page_id, true);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = cache->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    for (int t = 0; t < num_threads; ++t)
+      EXPECT_EQ(10, page->GetData()[64 + t]);
+    cache->UnpinPage(i, false);
+  }
+
+  delete cache;
+  delete disk_manager;
+  remove("test.db");
+}
+
+} // namespace cmudb
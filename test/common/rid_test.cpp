@@ -0,0 +1,36 @@
+/**
+ * rid_test.cpp
+ */
+
+#include <unordered_set>
+
+#include "common/rid.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(RIDTest, PackTest) {
+  // page ids of any tablespace survive the round trip
+  std::vector<RID> rids = {
+      RID(0, 0), RID(3, 17), RID(MakePageId(1, 0), 5),
+      RID(MakePageId(1, (static_cast<page_id_t>(1) << 31) + 7), 4095),
+      RID(MakePageId(MAX_TABLESPACES - 1, LOCAL_PAGE_MASK), 1)};
+  std::unordered_set<int64_t> packed;
+  for (auto &rid : rids) {
+    RID copy(rid.Get());
+    EXPECT_EQ(rid, copy);
+    EXPECT_EQ(rid.GetPageId(), copy.GetPageId());
+    EXPECT_EQ(rid.GetSlotNum(), copy.GetSlotNum());
+    EXPECT_TRUE(packed.insert(rid.Get()).second);
+  }
+
+  // the invalid rid stays invalid, and apart from the others
+  RID invalid;
+  RID copy(invalid.Get());
+  EXPECT_EQ(INVALID_PAGE_ID, copy.GetPageId());
+  EXPECT_EQ(-1, copy.GetSlotNum());
+  EXPECT_EQ(0u, packed.count(invalid.Get()));
+}
+
+} // namespace cmudb
@@ -0,0 +1,445 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "disk/compressed_disk_manager.h"
+#include "disk/lz_codec.h"
+#include "disk/uring_disk_manager.h"
+#include "page/header_page.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, UringAsyncTest) {
+  remove("test.db");
+  remove("test.log");
+  const int num_pages = 200; // more than one ring worth of requests
+  UringDiskManager *disk_manager = new UringDiskManager("test.db");
+
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < num_pages; i++) {
+    memset(&data[i * PAGE_SIZE], 'a' + i % 26, PAGE_SIZE);
+    futures.push_back(disk_manager->WritePageAsync(i, &data[i * PAGE_SIZE]));
+  }
+  disk_manager->SubmitBatch();
+  for (auto &f : futures)
+    f.wait();
+  futures.clear();
+
+  std::vector<char> buf(num_pages * PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++)
+    futures.push_back(disk_manager->ReadPageAsync(i, &buf[i * PAGE_SIZE]));
+  disk_manager->SubmitBatch();
+  for (auto &f : futures)
+    f.wait();
+  EXPECT_EQ(0, memcmp(data.data(), buf.data(), data.size()));
+
+  // synchronous interface, reading beyond the end of file gives zeros
+  char page[MAX_PAGE_SIZE];
+  memset(page, 'z', PAGE_SIZE);
+  disk_manager->WritePage(3, page);
+  disk_manager->ReadPage(3, &buf[0]);
+  EXPECT_EQ(0, memcmp(page, &buf[0], PAGE_SIZE));
+  disk_manager->ReadPage(num_pages + 10, page);
+  for (int i = 0; i < PAGE_SIZE; i++)
+    EXPECT_EQ(0, page[i]);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", DISK_DIRECT_IO);
+
+  // deliberately misaligned buffers
+  std::vector<char> data(3 * PAGE_SIZE + 1);
+  char *page = &data[1];
+  char *buf = &data[PAGE_SIZE + 1];
+  for (int i = 0; i < 10; i++) {
+    memset(page, 'a' + i, PAGE_SIZE);
+    disk_manager->WritePage(i, page);
+  }
+  for (int i = 9; i >= 0; i--) {
+    disk_manager->ReadPage(i, buf);
+    memset(page, 'a' + i, PAGE_SIZE);
+    EXPECT_EQ(0, memcmp(page, buf, PAGE_SIZE));
+  }
+  // beyond the end of file
+  disk_manager->ReadPage(20, buf);
+  for (int i = 0; i < PAGE_SIZE; i++)
+    EXPECT_EQ(0, buf[i]);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, AllocationTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // more than one bitmap page worth of pages
+  const int num_pages = BITMAP_PAGE_BITS + 100;
+  for (int i = 0; i < num_pages; i++)
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+
+  char data[MAX_PAGE_SIZE];
+  char buf[MAX_PAGE_SIZE];
+  for (int i = num_pages - 2; i < num_pages; i++) {
+    memset(data, 'a' + i % 26, PAGE_SIZE);
+    disk_manager->WritePage(i, data);
+  }
+  // freed pages are reused, lowest id first
+  disk_manager->DeallocatePage(7);
+  disk_manager->DeallocatePage(BITMAP_PAGE_BITS + 3);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(3); // double free is ignored
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // allocation state survives reopening the file
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(7, disk_manager->AllocatePage());
+  EXPECT_EQ(BITMAP_PAGE_BITS + 3, disk_manager->AllocatePage());
+  EXPECT_EQ(num_pages, disk_manager->AllocatePage());
+  for (int i = num_pages - 2; i < num_pages; i++) {
+    memset(data, 'a' + i % 26, PAGE_SIZE);
+    disk_manager->ReadPage(i, buf);
+    EXPECT_EQ(0, memcmp(data, buf, PAGE_SIZE));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  page_id_t a = disk_manager->AllocatePage();
+  page_id_t b = disk_manager->AllocatePage();
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(1, b);
+  // a fills up the first extent, then moves on to an empty one
+  for (int i = 2; i < EXTENT_SIZE; i++)
+    EXPECT_EQ(i, disk_manager->AllocatePage(a));
+  EXPECT_EQ(EXTENT_SIZE, disk_manager->AllocatePage(a));
+  // b doesn't interleave with a
+  EXPECT_EQ(2 * EXTENT_SIZE, disk_manager->AllocatePage(b));
+  EXPECT_EQ(EXTENT_SIZE + 1, disk_manager->AllocatePage(EXTENT_SIZE));
+  EXPECT_EQ(2 * EXTENT_SIZE + 1, disk_manager->AllocatePage(2 * EXTENT_SIZE));
+  // freed page in the extent is reused
+  disk_manager->DeallocatePage(5);
+  EXPECT_EQ(5, disk_manager->AllocatePage(a));
+
+  // vectored I/O across a bitmap page
+  const int first = BITMAP_PAGE_BITS - 50;
+  const int num_pages = 100;
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  std::vector<char> buf(num_pages * PAGE_SIZE);
+  std::vector<char *> pages;
+  std::vector<char *> bufs;
+  for (int i = 0; i < num_pages; i++) {
+    memset(&data[i * PAGE_SIZE], 'a' + i % 26, PAGE_SIZE);
+    pages.push_back(&data[i * PAGE_SIZE]);
+    bufs.push_back(&buf[i * PAGE_SIZE]);
+  }
+  disk_manager->WritePages(first, num_pages, pages.data());
+  disk_manager->ReadPages(first, num_pages, bufs.data());
+  EXPECT_EQ(0, memcmp(&data[0], &buf[0], num_pages * PAGE_SIZE));
+  for (int i = 0; i < num_pages; i++) {
+    disk_manager->ReadPage(first + i, bufs[0]);
+    EXPECT_EQ(0, memcmp(pages[i], bufs[0], PAGE_SIZE));
+  }
+  // beyond the end of file
+  disk_manager->ReadPages(first + num_pages, 2, bufs.data());
+  for (int i = 0; i < 2 * PAGE_SIZE; i++)
+    EXPECT_EQ(0, buf[i]);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ReadOnlyTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  char data[MAX_PAGE_SIZE];
+  char buf[MAX_PAGE_SIZE];
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    memset(data, 'a' + i, PAGE_SIZE);
+    disk_manager->WritePage(i, data);
+  }
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db", DISK_READ_ONLY);
+  EXPECT_TRUE(disk_manager->IsReadOnly());
+  disk_manager->Advise(ACCESS_SEQUENTIAL);
+  for (int i = 0; i < 10; i++) {
+    memset(data, 'a' + i, PAGE_SIZE);
+    const char *mapped = disk_manager->GetMappedPage(i);
+    ASSERT_NE(nullptr, mapped);
+    EXPECT_EQ(0, memcmp(data, mapped, PAGE_SIZE));
+    disk_manager->ReadPage(i, buf);
+    EXPECT_EQ(0, memcmp(data, buf, PAGE_SIZE));
+  }
+  EXPECT_EQ(nullptr, disk_manager->GetMappedPage(10));
+  // nothing can be changed
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+  memset(data, 'z', PAGE_SIZE);
+  disk_manager->WritePage(0, data);
+  disk_manager->ReadPage(0, buf);
+  EXPECT_EQ('a', buf[0]);
+  EXPECT_TRUE(disk_manager->IsAllocated(9));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, LZCodecTest) {
+  const int size = 4 * PAGE_SIZE;
+  std::vector<char> data(size);
+  std::vector<char> compressed(size);
+  std::vector<char> buf(size);
+  // repetitive, random and mixed input
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < size; i++) {
+      if (round == 0 || (round == 2 && i % 300 < 150))
+        data[i] = "hello world "[i % 12];
+      else
+        data[i] = static_cast<char>(rand());
+    }
+    int compressed_size =
+        LZCodec::Compress(&data[0], size, &compressed[0], size);
+    if (round == 0) {
+      EXPECT_LT(compressed_size, size / 10);
+    }
+    if (compressed_size == 0)
+      continue; // incompressible
+    EXPECT_EQ(size, LZCodec::Decompress(&compressed[0], compressed_size,
+                                        &buf[0], size));
+    EXPECT_EQ(0, memcmp(&data[0], &buf[0], size));
+    // too small for the result
+    EXPECT_EQ(-1, LZCodec::Decompress(&compressed[0], compressed_size, &buf[0],
+                                      size - 1));
+  }
+  // doesn't fit
+  EXPECT_EQ(0, LZCodec::Compress(&data[0], size, &compressed[0], 10));
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  remove("test.db");
+  remove("test.log");
+  remove("test.map");
+  remove("test.zdb");
+  const int num_pages = 100;
+  CompressedDiskManager *disk_manager = new CompressedDiskManager("test.db");
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  char buf[MAX_PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    char *page = &data[i * PAGE_SIZE];
+    if (i % 10 == 0) {
+      for (int j = 0; j < PAGE_SIZE; j++)
+        page[j] = static_cast<char>(rand());
+    } else {
+      for (int j = 0; j < PAGE_SIZE; j += 16) {
+        std::string row = "row " + std::to_string(i) + "." + std::to_string(j);
+        row.resize(16, ' ');
+        memcpy(page + j, row.c_str(), 16);
+      }
+    }
+    disk_manager->WritePage(i, page);
+  }
+  EXPECT_LT(disk_manager->GetStoredBytes(), num_pages * PAGE_SIZE / 2);
+  // no space is reserved for page images in the database file
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_LT(stat_buf.st_blocks * 512, num_pages * PAGE_SIZE / 2);
+  for (int i = 0; i < num_pages; i++) {
+    disk_manager->ReadPage(i, buf);
+    EXPECT_EQ(0, memcmp(&data[i * PAGE_SIZE], buf, PAGE_SIZE));
+  }
+
+  // a page that grows moves to another slot, its old one is reused
+  memset(&data[PAGE_SIZE], 0, PAGE_SIZE);
+  disk_manager->WritePage(1, &data[PAGE_SIZE]);
+  disk_manager->WritePage(10, &data[20 * PAGE_SIZE]);
+  disk_manager->WritePage(1, &data[10 * PAGE_SIZE]);
+  memcpy(&data[PAGE_SIZE], &data[10 * PAGE_SIZE], PAGE_SIZE);
+  memcpy(&data[10 * PAGE_SIZE], &data[20 * PAGE_SIZE], PAGE_SIZE);
+  disk_manager->DeallocatePage(99);
+  disk_manager->ReadPage(99, buf);
+  EXPECT_EQ(0, buf[0]);
+  delete disk_manager;
+
+  // the mapping survives reopening
+  disk_manager = new CompressedDiskManager("test.db");
+  for (int i = 0; i < num_pages - 1; i++) {
+    disk_manager->ReadPage(i, buf);
+    EXPECT_EQ(0, memcmp(&data[i * PAGE_SIZE], buf, PAGE_SIZE));
+  }
+  EXPECT_EQ(99, disk_manager->AllocatePage());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.map");
+  remove("test.zdb");
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", 0, 8192);
+  EXPECT_EQ(8192, PAGE_SIZE);
+  EXPECT_EQ((8192 - 4) / 40, HeaderPage::GetMaxRecordCount());
+  std::vector<char> data(PAGE_SIZE);
+  std::vector<char> buf(PAGE_SIZE);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    memset(&data[0], 'a' + i, PAGE_SIZE);
+    disk_manager->WritePage(i, &data[0]);
+  }
+
+  // a second database must share the page size of the open one
+  remove("test2.db");
+  remove("test2.log");
+  DiskManager *other = new DiskManager("test2.db", 0, 4096);
+  EXPECT_EQ(8192, PAGE_SIZE);
+  EXPECT_EQ(INVALID_PAGE_ID, other->AllocatePage());
+  delete other;
+  remove("test2.db");
+  other = new DiskManager("test2.db", 0, 8192);
+  EXPECT_EQ(0, other->AllocatePage());
+  delete other;
+  remove("test2.db");
+  remove("test2.log");
+  delete disk_manager;
+
+  // the page size of an existing file wins
+  disk_manager = new DiskManager("test.db", 0, 4096);
+  EXPECT_EQ(8192, PAGE_SIZE);
+  for (int i = 0; i < 10; i++) {
+    memset(&data[0], 'a' + i, PAGE_SIZE);
+    disk_manager->ReadPage(i, &buf[0]);
+    EXPECT_EQ(0, memcmp(&data[0], &buf[0], PAGE_SIZE));
+  }
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+
+  // a new file gets the default page size
+  disk_manager = new DiskManager("test.db", 0, 1000);
+  EXPECT_EQ(DEFAULT_PAGE_SIZE, PAGE_SIZE);
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, TablespaceTest) {
+  remove("test.db");
+  remove("test.log");
+  remove("test_index.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(1, disk_manager->GetNumTablespaces());
+  EXPECT_EQ(1, disk_manager->AddTablespace("test_index.db"));
+  EXPECT_EQ(1, disk_manager->AddTablespace("test_index.db"));
+  EXPECT_EQ(2, disk_manager->GetNumTablespaces());
+
+  // each tablespace numbers its pages from 0
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  page_id_t first = disk_manager->AllocatePage(TablespaceHint(1));
+  EXPECT_EQ(MakePageId(1, 0), first);
+  EXPECT_EQ(1, TablespaceOf(first));
+  EXPECT_EQ(MakePageId(1, 1), disk_manager->AllocatePage(first));
+  EXPECT_EQ(1, disk_manager->AllocatePage());
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage(TablespaceHint(2)));
+
+  std::vector<char> data(PAGE_SIZE);
+  std::vector<char> buf(PAGE_SIZE);
+  page_id_t pages[] = {0, 1, MakePageId(1, 0), MakePageId(1, 1)};
+  for (int i = 0; i < 4; i++) {
+    memset(&data[0], 'a' + i, PAGE_SIZE);
+    disk_manager->WritePage(pages[i], &data[0]);
+  }
+  delete disk_manager;
+
+  // the tablespace is opened again with the database
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(2, disk_manager->GetNumTablespaces());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(disk_manager->IsAllocated(pages[i]));
+    memset(&data[0], 'a' + i, PAGE_SIZE);
+    disk_manager->ReadPage(pages[i], &buf[0]);
+    EXPECT_EQ(0, memcmp(&data[0], &buf[0], PAGE_SIZE));
+  }
+  disk_manager->DeallocatePage(MakePageId(1, 0));
+  EXPECT_FALSE(disk_manager->IsAllocated(MakePageId(1, 0)));
+  EXPECT_TRUE(disk_manager->IsAllocated(0));
+  EXPECT_EQ(MakePageId(1, 0), disk_manager->AllocatePage(TablespaceHint(1)));
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+  remove("test_index.db");
+}
+
+TEST(DiskManagerTest, FormatVersionTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(DB_FORMAT_VERSION, disk_manager->GetFormatVersion());
+  // beyond what a 32-bit offset can address, the file stays sparse
+  page_id_t far_page_id = static_cast<page_id_t>(1) << 23;
+  std::vector<char> data(PAGE_SIZE, 'x');
+  std::vector<char> buf(PAGE_SIZE);
+  disk_manager->WritePage(far_page_id, &data[0]);
+  disk_manager->ReadPage(far_page_id, &buf[0]);
+  EXPECT_EQ(0, memcmp(&data[0], &buf[0], PAGE_SIZE));
+  delete disk_manager;
+
+  // files of version 1 have no version in their header, and are refused:
+  // their pages would be misread
+  std::fstream file("test.db", std::ios::binary | std::ios::in | std::ios::out);
+  FileHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  header.version = 0;
+  file.seekp(0);
+  file.write(reinterpret_cast<char *>(&header), sizeof(header));
+  file.flush();
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(1, disk_manager->GetFormatVersion());
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // and a newer version is refused
+  header.version = DB_FORMAT_VERSION + 1;
+  file.seekp(0);
+  file.write(reinterpret_cast<char *>(&header), sizeof(header));
+  file.close();
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
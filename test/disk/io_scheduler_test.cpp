@@ -0,0 +1,148 @@
+/**
+ * io_scheduler_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "disk/io_scheduler.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// records the I/O that reaches the disk, the read of page 100 waits until
+// released so that requests pile up in the scheduler
+class RecordingDiskManager : public DiskManager {
+public:
+  RecordingDiskManager(const std::string &db_file)
+      : DiskManager(db_file), released_(release_.get_future()) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    Record("w" + std::to_string(page_id));
+    DiskManager::WritePage(page_id, page_data);
+  }
+  void WritePages(page_id_t page_id, int count,
+                  const char *const *pages) override {
+    Record("w" + std::to_string(page_id) + "+" + std::to_string(count));
+    DiskManager::WritePages(page_id, count, pages);
+  }
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (page_id == 100)
+      released_.wait();
+    Record("r" + std::to_string(page_id));
+    DiskManager::ReadPage(page_id, page_data);
+  }
+  void ReadPages(page_id_t page_id, int count, char **pages) override {
+    Record("r" + std::to_string(page_id) + "+" + std::to_string(count));
+    DiskManager::ReadPages(page_id, count, pages);
+  }
+
+  std::vector<std::string> GetLog() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return log_;
+  }
+
+  std::promise<void> release_;
+
+private:
+  void Record(const std::string &op) {
+    std::lock_guard<std::mutex> guard(latch_);
+    log_.push_back(op);
+  }
+  std::shared_future<void> released_;
+  std::mutex latch_;
+  std::vector<std::string> log_;
+};
+
+TEST(IOSchedulerTest, SampleTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  IOScheduler *scheduler = new IOScheduler(disk_manager);
+  std::vector<std::vector<char>> data(20, std::vector<char>(PAGE_SIZE));
+  std::vector<std::future<void>> done;
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    memset(&data[i][0], 'a' + i, PAGE_SIZE);
+    done.push_back(scheduler->WritePage(i, &data[i][0]));
+  }
+  for (auto &f : done)
+    f.wait();
+
+  std::vector<char> buf(PAGE_SIZE);
+  for (int i = 0; i < 20; i++) {
+    scheduler->ReadPage(i, &buf[0]).wait();
+    EXPECT_EQ(0, memcmp(&data[i][0], &buf[0], PAGE_SIZE));
+  }
+  std::vector<std::vector<char>> bufs(20, std::vector<char>(PAGE_SIZE));
+  std::vector<char *> pages;
+  for (auto &b : bufs)
+    pages.push_back(&b[0]);
+  scheduler->ReadPages(0, 20, pages.data()).wait();
+  for (int i = 0; i < 20; i++)
+    EXPECT_EQ(0, memcmp(&data[i][0], pages[i], PAGE_SIZE));
+
+  char log_data[] = "log record";
+  scheduler->WriteLog(log_data, sizeof(log_data)).wait();
+  EXPECT_EQ(1, disk_manager->GetNumFlushes());
+
+  delete scheduler;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(IOSchedulerTest, PriorityTest) {
+  remove("test.db");
+  remove("test.log");
+  RecordingDiskManager *disk_manager = new RecordingDiskManager("test.db");
+  IOScheduler *scheduler = new IOScheduler(disk_manager, 1);
+  std::vector<char> blocked(PAGE_SIZE);
+  std::future<void> first = scheduler->ReadPage(100, &blocked[0]);
+
+  // queued while the only worker is busy: a prefetch, writes in descending
+  // order with page 3 written twice, and a foreground read
+  std::vector<std::vector<char>> bufs(4, std::vector<char>(PAGE_SIZE));
+  std::vector<char *> pages;
+  for (auto &b : bufs)
+    pages.push_back(&b[0]);
+  std::future<void> prefetch = scheduler->ReadPages(50, 4, pages.data());
+  std::vector<std::vector<char>> data(8, std::vector<char>(PAGE_SIZE));
+  std::vector<std::future<void>> writes;
+  for (int i = 7; i >= 0; i--) {
+    memset(&data[i][0], 'a' + i, PAGE_SIZE);
+    writes.push_back(scheduler->WritePage(i, &data[i][0]));
+  }
+  std::vector<char> newer(PAGE_SIZE, 'z');
+  writes.push_back(scheduler->WritePage(3, &newer[0]));
+  std::vector<char> buf(PAGE_SIZE);
+  std::future<void> read = scheduler->ReadPage(20, &buf[0]);
+  // served from the queued image, without going to the disk
+  scheduler->ReadPage(3, &buf[0]).wait();
+  EXPECT_EQ(0, memcmp(&newer[0], &buf[0], PAGE_SIZE));
+
+  disk_manager->release_.set_value();
+  first.wait();
+  read.wait();
+  prefetch.wait();
+  for (auto &f : writes)
+    f.wait();
+
+  // one vectored write for the adjacent pages
+  std::vector<std::string> expected = {"r100", "r20", "w0+8", "r50+4"};
+  EXPECT_EQ(expected, disk_manager->GetLog());
+  EXPECT_EQ(1u, scheduler->GetNumWrites());
+  disk_manager->ReadPage(3, &buf[0]);
+  EXPECT_EQ(0, memcmp(&newer[0], &buf[0], PAGE_SIZE));
+  disk_manager->ReadPage(7, &buf[0]);
+  EXPECT_EQ(0, memcmp(&data[7][0], &buf[0], PAGE_SIZE));
+
+  delete scheduler;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
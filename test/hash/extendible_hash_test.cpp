@@ -92,7 +92,8 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
     for (int i = 0; i < num_threads; i++) {
       threads[i].join();
     }
-    EXPECT_EQ(test->GetGlobalDepth(), 6);
+    // emptied buckets are merged, how far depends on the interleaving
+    EXPECT_LE(test->GetGlobalDepth(), 6);
     int val;
     EXPECT_EQ(0, test->Find(0, val));
     EXPECT_EQ(1, test->Find(8, val));
@@ -102,4 +103,71 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
   }
 }
 
+TEST(ExtendibleHashTest, MergeTest) {
+  ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(2);
+  for (int i = 0; i < 64; i++) {
+    test->Insert(i, i);
+  }
+  EXPECT_EQ(5, test->GetGlobalDepth());
+
+  // the buckets of the odd keys go, the directory keeps the even ones apart
+  for (int i = 1; i < 64; i += 2) {
+    EXPECT_TRUE(test->Remove(i));
+  }
+  EXPECT_EQ(5, test->GetGlobalDepth());
+  EXPECT_EQ(5, test->GetLocalDepth(0));
+  EXPECT_EQ(1, test->GetLocalDepth(1));
+  int val;
+  for (int i = 0; i < 64; i++) {
+    EXPECT_EQ(i % 2 == 0, test->Find(i, val));
+  }
+
+  // back to a single bucket once empty
+  for (int i = 0; i < 64; i += 2) {
+    EXPECT_TRUE(test->Remove(i));
+  }
+  EXPECT_EQ(0, test->GetGlobalDepth());
+  EXPECT_EQ(1, test->GetNumBuckets());
+  test->Insert(3, 3);
+  EXPECT_TRUE(test->Find(3, val));
+  EXPECT_EQ(3, val);
+
+  delete test;
+}
+
+TEST(ExtendibleHashTest, ConcurrentMixedTest) {
+  const int num_threads = 4;
+  const int num_keys = 1000;
+  ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(4);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, test]() {
+      // every thread owns the keys equal to tid modulo num_threads
+      for (int round = 0; round < 3; round++) {
+        for (int i = tid; i < num_keys; i += num_threads) {
+          test->Insert(i, i + round);
+        }
+        for (int i = tid; i < num_keys; i += num_threads) {
+          int val;
+          EXPECT_TRUE(test->Find(i, val));
+          EXPECT_EQ(i + round, val);
+        }
+        for (int i = tid; i < num_keys; i += num_threads) {
+          if (round < 2 || i % 3 != 0) {
+            EXPECT_TRUE(test->Remove(i));
+          }
+        }
+      }
+    }));
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  int val;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_EQ(i % 3 == 0, test->Find(i, val));
+  }
+  delete test;
+}
+
 } // namespace cmudb
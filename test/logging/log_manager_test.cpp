@@ -41,13 +41,13 @@ TEST(LogManagerTest, BasicLogging) {
   LOG_DEBUG("Turning off flushing thread");
 
   // some basic manually checking here
-  char buffer[PAGE_SIZE];
+  char buffer[MAX_PAGE_SIZE];
   storage_engine->disk_manager_->ReadLog(buffer, PAGE_SIZE, 0);
   int32_t size = *reinterpret_cast<int32_t *>(buffer);
   LOG_DEBUG("size  = %d", size);
-  size = *reinterpret_cast<int32_t *>(buffer + 20);
+  size = *reinterpret_cast<int32_t *>(buffer + 28);
   LOG_DEBUG("size  = %d", size);
-  size = *reinterpret_cast<int32_t *>(buffer + 44);
+  size = *reinterpret_cast<int32_t *>(buffer + 64);
   LOG_DEBUG("size  = %d", size);
 
   delete txn;
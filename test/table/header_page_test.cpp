@@ -10,7 +10,8 @@
 namespace cmudb {
 
 TEST(HeaderPageTest, UnitTest) {
-  DiskManager *disk_manager = new DiskManager("test.db");
+  // 27 records don't fit into the default 512 byte page
+  DiskManager *disk_manager = new DiskManager("test.db", 0, 4096);
   BufferPoolManager *buffer_pool_manager =
       new BufferPoolManager(20, disk_manager);
   page_id_t header_page_id;
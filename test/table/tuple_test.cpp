@@ -53,6 +53,12 @@ TEST(TupleTest, TableHeapTest) {
     // std::cout << i++ << std::endl;
     assert(table->MarkDelete(rid, transaction) == 1);
   }
+  // drop the table, its first page is reused right away
+  EXPECT_TRUE(table->DeleteTableHeap());
+  page_id_t page_id;
+  EXPECT_NE(nullptr, buffer_pool_manager->NewPage(page_id));
+  EXPECT_EQ(0, page_id);
+  buffer_pool_manager->UnpinPage(page_id, false);
   remove("test.db"); // remove db file
   remove("test.log");
   delete schema;